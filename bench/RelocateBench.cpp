@@ -0,0 +1,139 @@
+//
+// Relocation throughput: relocateImage on one thread vs. a ThreadPool of increasing size,
+// over synthetic PE64 images with a DIR64 fixup in every 8 byte slot of their pages.
+//
+// Build (from this directory):
+//   cl /std:c++20 /O2 /EHsc /I..\pepp RelocateBench.cpp ..\pepp\*.cpp ..\pepp\misc\*.cpp
+// Add /DPEPP_RELOCATION_JOB_SIZE=<fixups> to compare job sizes (default 16384).
+//
+// Usage: RelocateBench [fixups (default 1000000)] [max threads (default hardware threads)]
+//
+#include "PELibrary.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace pepp;
+
+namespace
+{
+	constexpr std::uint32_t page_size = 0x1000;
+	constexpr std::uint32_t fixups_per_page = page_size / sizeof(std::uint64_t);
+	constexpr int runs = 5;
+
+	//
+	// Headers, one section with `pages` pages of pointers, the relocation table after them (same section).
+	std::vector<std::uint8_t> makeImage(std::uint32_t pages)
+	{
+		const std::uint32_t blockSize = sizeof(IMAGE_BASE_RELOCATION) + fixups_per_page * sizeof(std::uint16_t);
+		const std::uint32_t tableRva = page_size + pages * page_size;
+		const std::uint32_t sectionSize = align(pages * page_size + pages * blockSize + sizeof(IMAGE_BASE_RELOCATION), page_size);
+
+		std::vector<std::uint8_t> image(0x400 + sectionSize);
+
+		auto* dos = reinterpret_cast<IMAGE_DOS_HEADER*>(image.data());
+		dos->e_magic = IMAGE_DOS_SIGNATURE;
+		dos->e_lfanew = 0x40;
+
+		auto* nt = reinterpret_cast<IMAGE_NT_HEADERS64*>(image.data() + 0x40);
+		nt->Signature = IMAGE_NT_SIGNATURE;
+		nt->FileHeader.Machine = IMAGE_FILE_MACHINE_AMD64;
+		nt->FileHeader.NumberOfSections = 1;
+		nt->FileHeader.SizeOfOptionalHeader = sizeof(IMAGE_OPTIONAL_HEADER64);
+		nt->OptionalHeader.Magic = IMAGE_NT_OPTIONAL_HDR64_MAGIC;
+		nt->OptionalHeader.ImageBase = 0x140000000ull;
+		nt->OptionalHeader.FileAlignment = 0x200;
+		nt->OptionalHeader.SectionAlignment = page_size;
+		nt->OptionalHeader.SizeOfHeaders = 0x400;
+		nt->OptionalHeader.SizeOfImage = page_size + sectionSize;
+		nt->OptionalHeader.NumberOfRvaAndSizes = IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+		nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC] = { tableRva, pages * blockSize };
+
+		auto* section = IMAGE_FIRST_SECTION(nt);
+		std::memcpy(section->Name, ".data", 5);
+		section->VirtualAddress = page_size;
+		section->Misc.VirtualSize = sectionSize;
+		section->PointerToRawData = 0x400;
+		section->SizeOfRawData = sectionSize;
+		section->Characteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ | IMAGE_SCN_MEM_WRITE;
+
+		auto at = [&](std::uint32_t rva) { return image.data() + 0x400 + (rva - page_size); };
+
+		for (std::uint32_t page = 0; page < pages; page++)
+		{
+			const std::uint32_t pageRva = page_size + page * page_size;
+			auto* block = reinterpret_cast<IMAGE_BASE_RELOCATION*>(at(tableRva + page * blockSize));
+			auto* entries = reinterpret_cast<std::uint16_t*>(block + 1);
+
+			block->VirtualAddress = pageRva;
+			block->SizeOfBlock = blockSize;
+
+			for (std::uint32_t slot = 0; slot < fixups_per_page; slot++)
+			{
+				std::uint64_t pointer = nt->OptionalHeader.ImageBase + pageRva + slot * sizeof(std::uint64_t);
+				std::memcpy(at(pageRva + slot * sizeof(std::uint64_t)), &pointer, sizeof(pointer));
+				entries[slot] = craftRelocationBlockEntry(REL_BASED_DIR64, static_cast<std::uint16_t>(slot * sizeof(std::uint64_t)));
+			}
+		}
+
+		return image;
+	}
+
+	//
+	// Best of `runs`, in milliseconds. Relocates back and forth so every run patches the same image.
+	template<typename Relocate>
+	double best(Image64& image, Relocate&& relocate)
+	{
+		double result = 0.0;
+
+		for (int run = 0; run < runs; run++)
+		{
+			auto begin = std::chrono::steady_clock::now();
+			bool ok = relocate(run % 2 ? 0x140000000ull : 0x7ff600000000ull);
+			auto end = std::chrono::steady_clock::now();
+
+			if (!ok)
+			{
+				std::fprintf(stderr, "relocateImage failed\n");
+				std::exit(1);
+			}
+
+			double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+			if (run == 0 || ms < result)
+				result = ms;
+		}
+
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::uint32_t fixups = argc > 1 ? static_cast<std::uint32_t>(std::strtoul(argv[1], nullptr, 0)) : 1000000;
+	std::size_t maxThreads = argc > 2 ? std::strtoul(argv[2], nullptr, 0) : std::thread::hardware_concurrency();
+	if (maxThreads == 0)
+		maxThreads = 1;
+
+	const std::uint32_t pages = (fixups + fixups_per_page - 1) / fixups_per_page;
+	std::vector<std::uint8_t> data = makeImage(pages);
+
+	Image64 image;
+	image.setFromMemory(data.data(), data.size());
+
+	std::printf("%u fixups in %u pages, %.1f MB image\n", pages * fixups_per_page, pages, data.size() / (1024.0 * 1024.0));
+
+	const double serial = best(image, [&](std::uint64_t base) { return image.relocateImage(static_cast<uintptr_t>(base)); });
+	std::printf("%8s %10.2f ms\n", "serial", serial);
+
+	for (std::size_t threads = 2; threads <= maxThreads; threads *= 2)
+	{
+		msc::ThreadPool pool(threads);
+
+		const double ms = best(image, [&](std::uint64_t base) { return image.relocateImage(static_cast<uintptr_t>(base), pool); });
+		std::printf("%5zu thr %10.2f ms  x%.2f\n", threads, ms, serial / ms);
+	}
+
+	return 0;
+}
@@ -0,0 +1,142 @@
+//
+// RVA -> file offset translation: a loop over PEHeader::rvaToOffset (one binary search per call) vs.
+// SectionIndex::Table::translateMany (SIMD matching for small section tables), over synthetic PE64 images.
+// RVAs are random over the image (a few percent land in no section), then sorted like a walk over a table.
+//
+// Build (from this directory):
+//   cl /std:c++20 /O2 /EHsc /I..\pepp TranslateBench.cpp ..\pepp\*.cpp ..\pepp\misc\*.cpp
+//
+// Usage: TranslateBench [rvas (default 1000000)] [sections (default 8)]
+//
+#include "PELibrary.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+using namespace pepp;
+
+namespace
+{
+	constexpr std::uint32_t section_size = 0x10000;
+	constexpr int runs = 5;
+
+	//
+	// Headers and `sections` sections of section_size bytes, the raw data of each one 0x200 bytes
+	// further from its rva than the one before so no single offset works for all of them.
+	std::vector<std::uint8_t> makeImage(std::uint16_t sections)
+	{
+		const std::uint32_t headers = 0x1000;
+		std::vector<std::uint8_t> image(headers + sections * (section_size + 0x200));
+
+		auto* dos = reinterpret_cast<IMAGE_DOS_HEADER*>(image.data());
+		dos->e_magic = IMAGE_DOS_SIGNATURE;
+		dos->e_lfanew = 0x40;
+
+		auto* nt = reinterpret_cast<IMAGE_NT_HEADERS64*>(image.data() + 0x40);
+		nt->Signature = IMAGE_NT_SIGNATURE;
+		nt->FileHeader.Machine = IMAGE_FILE_MACHINE_AMD64;
+		nt->FileHeader.NumberOfSections = sections;
+		nt->FileHeader.SizeOfOptionalHeader = sizeof(IMAGE_OPTIONAL_HEADER64);
+		nt->OptionalHeader.Magic = IMAGE_NT_OPTIONAL_HDR64_MAGIC;
+		nt->OptionalHeader.ImageBase = 0x140000000ull;
+		nt->OptionalHeader.FileAlignment = 0x200;
+		nt->OptionalHeader.SectionAlignment = 0x1000;
+		nt->OptionalHeader.SizeOfHeaders = headers;
+		nt->OptionalHeader.SizeOfImage = 0x1000 + sections * (section_size + 0x1000);
+		nt->OptionalHeader.NumberOfRvaAndSizes = IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+
+		auto* section = IMAGE_FIRST_SECTION(nt);
+
+		for (std::uint16_t i = 0; i < sections; i++)
+		{
+			char name[IMAGE_SIZEOF_SHORT_NAME + 1];
+			std::snprintf(name, sizeof(name), ".s%u", i);
+			std::memcpy(section[i].Name, name, std::strlen(name));
+
+			// A page of unmapped rvas between sections, the misses.
+			section[i].VirtualAddress = 0x1000 + i * (section_size + 0x1000);
+			section[i].Misc.VirtualSize = section_size;
+			section[i].PointerToRawData = headers + i * (section_size + 0x200);
+			section[i].SizeOfRawData = section_size;
+			section[i].Characteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ;
+		}
+
+		return image;
+	}
+
+	//
+	// Best of `runs`, in milliseconds.
+	template<typename Translate>
+	double best(Translate&& translate)
+	{
+		double result = 0.0;
+
+		for (int run = 0; run < runs; run++)
+		{
+			auto begin = std::chrono::steady_clock::now();
+			translate();
+			auto end = std::chrono::steady_clock::now();
+
+			double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+			if (run == 0 || ms < result)
+				result = ms;
+		}
+
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 1000000;
+	std::uint16_t sections = argc > 2 ? static_cast<std::uint16_t>(std::strtoul(argv[2], nullptr, 0)) : 8;
+	if (sections == 0)
+		sections = 1;
+
+	std::vector<std::uint8_t> data = makeImage(sections);
+
+	Image64 image;
+	image.setFromMemory(data.data(), data.size());
+
+	const PEHeader<64>& header = image.getPEHdr();
+	const SectionIndex::Table& table = header.getSectionIndex().rvaTable();
+
+	std::vector<std::uint32_t> rvas(count);
+	std::mt19937 random(0x5eed);
+	std::uniform_int_distribution<std::uint32_t> pick(0x1000, header.getOptionalHdr().getSizeOfImage() - 1);
+
+	for (std::uint32_t& rva : rvas)
+		rva = pick(random);
+
+	std::vector<std::uint32_t> scalar(count), batch(count);
+
+	std::printf("%zu rvas over %u sections\n", count, sections);
+
+	for (const char* order : { "random", "sorted" })
+	{
+		if (std::strcmp(order, "sorted") == 0)
+			std::sort(rvas.begin(), rvas.end());
+
+		const double loop = best([&] {
+			for (std::size_t n = 0; n < count; n++)
+				scalar[n] = header.rvaToOffset(rvas[n]);
+		});
+
+		const double many = best([&] { table.translateMany(rvas.data(), batch.data(), count, 0); });
+
+		if (scalar != batch)
+		{
+			std::fprintf(stderr, "translateMany and rvaToOffset disagree\n");
+			return 1;
+		}
+
+		std::printf("%s\n", order);
+		std::printf("  %-14s %10.2f ms\n", "rvaToOffset", loop);
+		std::printf("  %-14s %10.2f ms  x%.2f\n", "translateMany", many, loop / many);
+	}
+
+	return 0;
+}
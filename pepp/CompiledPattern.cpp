@@ -0,0 +1,283 @@
+#include "PELibrary.hpp"
+#include "misc/Simd.hpp"
+#include <array>
+#include <bit>
+
+using namespace pepp;
+
+namespace
+{
+	//
+	// Rough byte frequencies in x86/x64 code and PE data (higher = more common).
+	// Scans anchor on the least common bytes of a pattern to keep candidate verification rare.
+	//
+	constexpr std::array<std::uint8_t, 256> byte_weights = [] {
+		std::array<std::uint8_t, 256> w{};
+
+		for (auto& v : w)
+			v = 16;
+
+		w[0x00] = 255; w[0xFF] = 200; w[0xCC] = 170; w[0x48] = 160; w[0x8B] = 150;
+		w[0x89] = 120; w[0x24] = 110; w[0x4C] = 100; w[0x0F] = 100; w[0xE8] = 95;
+		w[0x44] = 90;  w[0x83] = 90;  w[0x8D] = 85;  w[0x01] = 85;  w[0x85] = 80;
+		w[0x74] = 75;  w[0xC3] = 70;  w[0x90] = 70;  w[0x45] = 65;  w[0x75] = 65;
+		w[0x40] = 60;  w[0x41] = 60;  w[0x49] = 55;  w[0x08] = 55;  w[0x10] = 55;
+		w[0x20] = 50;  w[0xC0] = 50;  w[0x33] = 45;  w[0xC7] = 45;  w[0x84] = 45;
+		w[0x4D] = 40;  w[0x02] = 40;  w[0x04] = 40;  w[0x28] = 40;  w[0x30] = 40;
+		w[0x38] = 35;  w[0x18] = 35;  w[0x80] = 35;  w[0xEB] = 35;  w[0xE9] = 30;
+		w[0x03] = 30;  w[0x05] = 30;  w[0x0C] = 30;  w[0x50] = 30;  w[0x55] = 30;
+		w[0x5D] = 25;  w[0x5F] = 25;  w[0x63] = 25;  w[0xB8] = 25;  w[0xFE] = 25;
+
+		return w;
+	}();
+}
+
+CompiledPattern::CompiledPattern(std::string_view pattern)
+{
+	compile(pattern);
+}
+
+std::uint8_t CompiledPattern::byteWeight(std::uint8_t value) noexcept
+{
+	return byte_weights[value];
+}
+
+bool CompiledPattern::compile(std::string_view pattern)
+{
+	constexpr auto ascii_to_nibble = [](const char ch) -> int {
+		if (ch >= '0' && ch <= '9')
+			return ch - '0';
+		if (ch >= 'A' && ch <= 'F')
+			return ch - 'A' + 0xA;
+		if (ch >= 'a' && ch <= 'f')
+			return ch - 'a' + 0xA;
+		return -1;
+	};
+
+	m_bytes.clear();
+	m_mask.clear();
+
+	for (std::size_t c = 0; c < pattern.size();)
+	{
+		if (pattern[c] == ' ')
+		{
+			++c;
+			continue;
+		}
+
+		//
+		// "?" and "??" are both a single wildcard byte.
+		if (pattern[c] == '?')
+		{
+			c += (c + 1 < pattern.size() && pattern[c + 1] == '?') ? 2 : 1;
+			m_bytes.push_back(0x00);
+			m_mask.push_back(0x00);
+			continue;
+		}
+
+		int hi = ascii_to_nibble(pattern[c]);
+		int lo = c + 1 < pattern.size() ? ascii_to_nibble(pattern[c + 1]) : -1;
+
+		if (hi < 0 || lo < 0)
+		{
+			m_bytes.clear();
+			m_mask.clear();
+			return false;
+		}
+
+		m_bytes.push_back(static_cast<std::uint8_t>((hi << 4) | lo));
+		m_mask.push_back(0xFF);
+		c += 2;
+	}
+
+	_finalize();
+	return valid();
+}
+
+bool CompiledPattern::assign(const std::uint8_t* bytes, std::size_t size, const std::uint8_t* mask)
+{
+	m_bytes.assign(bytes, bytes + size);
+
+	if (mask)
+		m_mask.assign(mask, mask + size);
+	else
+		m_mask.assign(size, 0xFF);
+
+	_finalize();
+	return valid();
+}
+
+void CompiledPattern::_finalize()
+{
+	m_anchor = npos;
+	m_anchor2 = npos;
+
+	for (std::size_t i = 0; i < m_bytes.size(); i++)
+	{
+		// Normalize the mask to all-or-nothing and pre-mask the bytes, matches() relies on it.
+		m_mask[i] = m_mask[i] ? 0xFF : 0x00;
+		m_bytes[i] &= m_mask[i];
+
+		if (!m_mask[i])
+			continue;
+
+		//
+		// Keep the two least common bytes (by weight) as anchors.
+		if (m_anchor == npos || byte_weights[m_bytes[i]] < byte_weights[m_bytes[m_anchor]])
+		{
+			m_anchor2 = m_anchor;
+			m_anchor = i;
+		}
+		else if (m_anchor2 == npos || byte_weights[m_bytes[i]] < byte_weights[m_bytes[m_anchor2]])
+		{
+			m_anchor2 = i;
+		}
+	}
+
+	//
+	// Patterns made up only of wildcards aren't useful signatures.
+	if (m_anchor == npos)
+	{
+		m_bytes.clear();
+		m_mask.clear();
+		m_anchor = 0;
+	}
+
+	if (m_anchor2 == npos)
+		m_anchor2 = m_anchor;
+
+	std::memset(m_headBytes, 0, sizeof(m_headBytes));
+	std::memset(m_headMask, 0, sizeof(m_headMask));
+
+	for (std::size_t i = 0; i < m_bytes.size() && i < sizeof(m_headBytes); i++)
+	{
+		m_headBytes[i] = m_bytes[i];
+		m_headMask[i] = m_mask[i];
+	}
+}
+
+std::size_t CompiledPattern::find(const std::uint8_t* data, std::size_t size, std::size_t start) const noexcept
+{
+	if (!valid() || size < m_bytes.size() || start > size - m_bytes.size())
+		return npos;
+
+#if PEPP_ARCH_X86
+	if (simd::cpuFeatures().avx2)
+		return _findAvx2(data, size, start);
+#endif
+#if PEPP_HAS_SSE2
+	return _findSse2(data, size, start);
+#else
+	return _findScalar(data, size, start);
+#endif
+}
+
+std::size_t CompiledPattern::_findScalar(const std::uint8_t* data, std::size_t size, std::size_t start) const noexcept
+{
+	const std::size_t last = size - m_bytes.size();
+	const std::uint8_t anchorByte = m_bytes[m_anchor];
+	const std::uint8_t anchorByte2 = m_bytes[m_anchor2];
+
+	for (std::size_t i = start; i <= last;)
+	{
+		//
+		// Jump straight to the next occurrence of the rarest byte.
+		const void* hit = std::memchr(data + i + m_anchor, anchorByte, last - i + 1);
+		if (hit == nullptr)
+			break;
+
+		i = static_cast<const std::uint8_t*>(hit) - data - m_anchor;
+
+		if (data[i + m_anchor2] == anchorByte2 && matches(data + i))
+			return i;
+
+		++i;
+	}
+
+	return npos;
+}
+
+#if PEPP_HAS_SSE2
+std::size_t CompiledPattern::_findSse2(const std::uint8_t* data, std::size_t size, std::size_t start) const noexcept
+{
+	const std::size_t last = size - m_bytes.size();
+	const __m128i anchor = _mm_set1_epi8((char)m_bytes[m_anchor]);
+	const __m128i anchor2 = _mm_set1_epi8((char)m_bytes[m_anchor2]);
+	const __m128i headBytes = _mm_loadu_si128((const __m128i*)m_headBytes);
+	const __m128i headMask = _mm_loadu_si128((const __m128i*)m_headMask);
+	std::size_t i = start;
+
+	//
+	// 16 candidate positions per step: both anchors must match before the pattern is verified.
+	for (; i <= last && last - i >= 15; i += 16)
+	{
+		__m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + i + m_anchor)), anchor);
+		__m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + i + m_anchor2)), anchor2);
+		std::uint32_t candidates = (std::uint32_t)_mm_movemask_epi8(_mm_and_si128(a, b));
+
+		while (candidates)
+		{
+			std::size_t pos = i + std::countr_zero(candidates);
+
+			if (pos + 16 <= size)
+			{
+				// Masked compare of the first 16 bytes, then the rest (if any).
+				__m128i block = _mm_and_si128(_mm_loadu_si128((const __m128i*)(data + pos)), headMask);
+				if (_mm_movemask_epi8(_mm_cmpeq_epi8(block, headBytes)) == 0xFFFF && _matchesFrom(data + pos, 16))
+					return pos;
+			}
+			else if (matches(data + pos))
+			{
+				return pos;
+			}
+
+			candidates &= candidates - 1;
+		}
+	}
+
+	return i <= last ? _findScalar(data, size, i) : npos;
+}
+#endif
+
+#if PEPP_ARCH_X86
+PEPP_TARGET("avx2")
+std::size_t CompiledPattern::_findAvx2(const std::uint8_t* data, std::size_t size, std::size_t start) const noexcept
+{
+	const std::size_t last = size - m_bytes.size();
+	const __m256i anchor = _mm256_set1_epi8((char)m_bytes[m_anchor]);
+	const __m256i anchor2 = _mm256_set1_epi8((char)m_bytes[m_anchor2]);
+	const __m256i headBytes = _mm256_loadu_si256((const __m256i*)m_headBytes);
+	const __m256i headMask = _mm256_loadu_si256((const __m256i*)m_headMask);
+	std::size_t i = start;
+
+	//
+	// 32 candidate positions per step: both anchors must match before the pattern is verified.
+	for (; i <= last && last - i >= 31; i += 32)
+	{
+		__m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + i + m_anchor)), anchor);
+		__m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + i + m_anchor2)), anchor2);
+		std::uint32_t candidates = (std::uint32_t)_mm256_movemask_epi8(_mm256_and_si256(a, b));
+
+		while (candidates)
+		{
+			std::size_t pos = i + std::countr_zero(candidates);
+
+			if (pos + 32 <= size)
+			{
+				// Masked compare of the first 32 bytes, then the rest (if any).
+				__m256i block = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(data + pos)), headMask);
+				if ((std::uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, headBytes)) == 0xFFFFFFFF && _matchesFrom(data + pos, 32))
+					return pos;
+			}
+			else if (matches(data + pos))
+			{
+				return pos;
+			}
+
+			candidates &= candidates - 1;
+		}
+	}
+
+	return i <= last ? _findScalar(data, size, i) : npos;
+}
+#endif
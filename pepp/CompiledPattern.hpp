@@ -0,0 +1,94 @@
+#pragma once
+
+namespace pepp
+{
+	///
+	// - class CompiledPattern
+	// - IDA-style byte signature ("48 8B 05 ? ? ? ? C3", "??" works as well) parsed once into byte/mask arrays,
+	// - so a signature set can be scanned over any number of images without parsing the text again.
+	///
+	class CompiledPattern
+	{
+		//! Pattern bytes, wildcard positions hold 0
+		std::vector<std::uint8_t>	m_bytes;
+		//! 0xFF for bytes that must match, 0x00 for wildcards
+		std::vector<std::uint8_t>	m_mask;
+		//! Positions of the two least common non-wildcard bytes, scans only verify where both match
+		std::size_t					m_anchor = 0;
+		std::size_t					m_anchor2 = 0;
+		//! First 32 bytes/mask, zero padded, for vector verification of candidates
+		std::uint8_t				m_headBytes[32]{};
+		std::uint8_t				m_headMask[32]{};
+	public:
+		static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+		CompiledPattern() = default;
+
+		//! Compile a pattern, check valid() for the result
+		CompiledPattern(std::string_view pattern);
+
+		//! Compile a pattern, returns false (and leaves the pattern empty) on malformed input
+		bool compile(std::string_view pattern);
+
+		//! Build from raw bytes, `mask` (optional) uses 0x00 for wildcard positions
+		bool assign(const std::uint8_t* bytes, std::size_t size, const std::uint8_t* mask = nullptr);
+
+		//! Pattern has at least one non-wildcard byte
+		bool valid() const noexcept {
+			return !m_bytes.empty();
+		}
+
+		//! Length of the pattern in bytes (wildcards included)
+		std::size_t size() const noexcept {
+			return m_bytes.size();
+		}
+
+		const std::uint8_t* bytes() const noexcept {
+			return m_bytes.data();
+		}
+
+		const std::uint8_t* mask() const noexcept {
+			return m_mask.data();
+		}
+
+		//! Position of the least common non-wildcard byte
+		std::size_t anchor() const noexcept {
+			return m_anchor;
+		}
+
+		//! Position of the second least common non-wildcard byte (same as anchor() if there is only one)
+		std::size_t secondAnchor() const noexcept {
+			return m_anchor2;
+		}
+
+		//! How common a byte is in code/PE data (higher = more common), used to choose anchors
+		static std::uint8_t byteWeight(std::uint8_t value) noexcept;
+
+		//! Does the pattern match at `data` (which must hold at least size() bytes)?
+		bool matches(const std::uint8_t* data) const noexcept {
+			return _matchesFrom(data, 0);
+		}
+
+		//! Position of the first match in [data + start, data + size), or npos
+		//! Uses the widest engine the CPU supports (AVX2, SSE2 or scalar).
+		std::size_t find(const std::uint8_t* data, std::size_t size, std::size_t start = 0) const noexcept;
+
+	private:
+		void _finalize();
+
+		//! Compare pattern bytes [from, size()) against `data`
+		bool _matchesFrom(const std::uint8_t* data, std::size_t from) const noexcept {
+			for (std::size_t i = from; i < m_bytes.size(); i++)
+			{
+				if ((data[i] & m_mask[i]) != m_bytes[i])
+					return false;
+			}
+			return true;
+		}
+
+		//! Scan engines, `start` <= size - size() is guaranteed by find()
+		std::size_t _findScalar(const std::uint8_t* data, std::size_t size, std::size_t start) const noexcept;
+		std::size_t _findSse2(const std::uint8_t* data, std::size_t size, std::size_t start) const noexcept;
+		std::size_t _findAvx2(const std::uint8_t* data, std::size_t size, std::size_t start) const noexcept;
+	};
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+namespace pepp
+{
+	///
+	// - class DelayImportDirectory
+	// - Delay load descriptors (DIRECTORY_ENTRY_DELAY_IMPORT). Imports are yielded as ImportEntry_t,
+	// - import_rva being the slot in the delay load IAT, so dependency scans can treat both tables alike.
+	// - Descriptors without the rva based attribute (old linkers) hold VAs, they are translated.
+	// - Iteration and lookups come from ImportTable.
+	///
+	template<unsigned int bitsize>
+	class DelayImportDirectory : public ImportTable<bitsize, detail::Image_t<>::DelayImportDescriptor_t>
+	{
+		friend class Image<32>;
+		friend class Image<64>;
+
+		using Table_t = ImportTable<bitsize, detail::Image_t<>::DelayImportDescriptor_t>;
+		using typename Table_t::Descriptor_t;
+		using Table_t::m_image;
+		using Table_t::m_base;
+		using Table_t::_resetIndex;
+	public:
+		DelayImportDirectory() = default;
+
+		bool isPresent() const noexcept {
+			return m_base != nullptr;
+		}
+
+	private:
+		//! Setup the directory
+		void _setup(Image<bitsize>* image) {
+			_resetIndex();
+			m_image = image;
+			m_base = nullptr;
+
+			if (!image->hasDataDirectory(DIRECTORY_ENTRY_DELAY_IMPORT))
+				return;
+
+			std::uint32_t offset = image->getPEHdr().rvaToOffset(
+				image->getPEHdr().getOptionalHdr().getDataDir(DIRECTORY_ENTRY_DELAY_IMPORT).VirtualAddress);
+
+			if (offset != 0 && offset + sizeof(Descriptor_t) <= image->view().size())
+				m_base = reinterpret_cast<Descriptor_t*>(&image->base()[offset]);
+		}
+	};
+}
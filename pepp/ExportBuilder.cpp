@@ -0,0 +1,228 @@
+#include "PELibrary.hpp"
+
+#include <map>
+
+using namespace pepp;
+
+// Explicit templates.
+template class ExportBuilder<32>;
+template class ExportBuilder<64>;
+
+template<unsigned int bitsize>
+ExportBuilder<bitsize>::ExportBuilder(Image<bitsize>& image)
+	: m_image(&image)
+{
+}
+
+template<unsigned int bitsize>
+void ExportBuilder<bitsize>::add(std::string_view name, std::uint32_t rva, std::uint32_t ordinal)
+{
+	m_entries.push_back({ std::string(name), rva, std::string(), ordinal });
+}
+
+template<unsigned int bitsize>
+void ExportBuilder<bitsize>::addForwarder(std::string_view name, std::string_view forwarder, std::uint32_t ordinal)
+{
+	m_entries.push_back({ std::string(name), 0, std::string(forwarder), ordinal });
+}
+
+template<unsigned int bitsize>
+bool ExportBuilder<bitsize>::build(std::string_view section_name)
+{
+	using Directory_t = detail::Image_t<>::ExportDirectory_t;
+
+	struct Function_t
+	{
+		std::uint32_t	rva;
+		std::string		forwarder;
+	};
+
+	// Resizing needs an owned buffer, take it before any offsets are computed.
+	m_image->buffer();
+
+	ExportDirectory<bitsize>& exports = m_image->getExportDir();
+	const bool hasExports = exports.isPresent();
+	const IMAGE_DATA_DIRECTORY oldDir = m_image->getPEHdr().getOptionalHdr().getDataDir(DIRECTORY_ENTRY_EXPORT);
+
+	auto stringAt = [this](std::uint32_t rva) -> std::string {
+		std::uint32_t offset = m_image->getPEHdr().rvaToOffset(rva);
+		if (offset == 0 || offset >= m_image->view().size())
+			return {};
+
+		const char* str = m_image->view().template as<const char*>(offset);
+		return std::string(str, strnlen(str, m_image->view().size() - offset));
+	};
+
+	//
+	// 1) Existing exports. Strings are copied, the old directory (forwarders included) may be overwritten.
+	// Names are kept in byte order, the order the loader binary searches them in.
+	std::map<std::uint32_t, Function_t> functions;
+	std::map<std::string, std::uint32_t> names;
+	Directory_t header{};
+	std::string moduleName = m_moduleName;
+
+	if (hasExports)
+	{
+		header = *exports.m_base;
+
+		if (moduleName.empty())
+			moduleName = stringAt(header.Name);
+
+		for (std::uint32_t i = 0; i < header.NumberOfFunctions; i++)
+		{
+			std::uint32_t offset = m_image->getPEHdr().rvaToOffset(header.AddressOfFunctions + sizeof(std::uint32_t) * i);
+			if (offset == 0 || offset + sizeof(std::uint32_t) > m_image->view().size())
+				break;
+
+			std::uint32_t rva = m_image->view().template deref<std::uint32_t>(offset);
+			if (rva == 0)
+				continue;
+
+			if (exports.isForwarder(rva))
+				functions[header.Base + i] = { 0, std::string(exports.getForwarder(rva)) };
+			else
+				functions[header.Base + i] = { rva, std::string() };
+		}
+
+		for (std::uint32_t i = 0; i < header.NumberOfNames; i++)
+			names.emplace(std::string(exports.getName(i)), header.Base + exports.getNameOrdinal(i));
+	}
+
+	//
+	// 2) Queued exports, explicit ordinals first so the automatic ones can't take them.
+	std::vector<std::uint32_t> taken;
+
+	auto place = [&](const Entry_t& entry, std::uint32_t ordinal) -> bool {
+		if (std::find(taken.begin(), taken.end(), ordinal) != taken.end())
+			return false;
+
+		// An ordinal in use can only be taken over by the name that owns it.
+		auto existing = entry.name.empty() ? names.end() : names.find(entry.name);
+		if (functions.count(ordinal) && (existing == names.end() || existing->second != ordinal))
+			return false;
+
+		taken.push_back(ordinal);
+		functions[ordinal] = { entry.rva, entry.forwarder };
+		if (!entry.name.empty())
+			names[entry.name] = ordinal;
+		return true;
+	};
+
+	for (const Entry_t& entry : m_entries)
+	{
+		if (entry.ordinal == 0)
+			continue;
+
+		//
+		// Replacing a name with a new ordinal: its old function stays exported by ordinal.
+		if (!entry.name.empty())
+		{
+			auto existing = names.find(entry.name);
+			if (existing != names.end() && existing->second != entry.ordinal)
+				names.erase(existing);
+		}
+
+		if (!place(entry, entry.ordinal))
+			return false;
+	}
+
+	std::uint32_t next = functions.empty() ? 1 : functions.rbegin()->first + 1;
+
+	for (const Entry_t& entry : m_entries)
+	{
+		if (entry.ordinal != 0)
+			continue;
+
+		// Exports by ordinal only need an explicit ordinal.
+		if (entry.name.empty())
+			return false;
+
+		auto existing = names.find(entry.name);
+		if (!place(entry, existing != names.end() ? existing->second : next++))
+			return false;
+	}
+
+	if (functions.empty())
+		return true;
+
+	const std::uint32_t base = functions.begin()->first;
+	const std::uint32_t count = functions.rbegin()->first - base + 1;
+
+	// Import thunks carry 16 bit ordinals, name ordinals are 16 bit indices.
+	if (functions.rbegin()->first > 0xffff || count > 0x10000)
+		return false;
+
+	//
+	// 3) Layout: directory, function table, name table, name ordinals, then the strings.
+	const std::uint32_t functionsOffset = sizeof(Directory_t);
+	const std::uint32_t namesOffset = functionsOffset + count * sizeof(std::uint32_t);
+	const std::uint32_t ordinalsOffset = namesOffset + static_cast<std::uint32_t>(names.size() * sizeof(std::uint32_t));
+	std::uint32_t size = ordinalsOffset + static_cast<std::uint32_t>(names.size() * sizeof(std::uint16_t));
+
+	size += static_cast<std::uint32_t>(moduleName.size() + 1);
+	for (auto const& [name, ordinal] : names)
+		size += static_cast<std::uint32_t>(name.size() + 1);
+	for (auto const& [ordinal, function] : functions)
+		size += function.forwarder.empty() ? 0 : static_cast<std::uint32_t>(function.forwarder.size() + 1);
+
+	//
+	// 4) Place and write the block.
+	const std::uint32_t oldOffset = hasExports ? m_image->getPEHdr().rvaToOffset(oldDir.VirtualAddress) : 0;
+	const std::uint32_t offset = m_image->allocateInSection(section_name, size, sizeof(std::uint32_t));
+
+	if (offset == NO_FREE_SPACE)
+		return false;
+
+	const std::uint32_t rva = m_image->getPEHdr().offsetToRva(offset);
+	std::uint8_t* block = &m_image->buffer()[offset];
+	std::uint32_t strings = ordinalsOffset + static_cast<std::uint32_t>(names.size() * sizeof(std::uint16_t));
+
+	std::memset(block, 0, size);
+
+	auto writeString = [&](std::string_view str) -> std::uint32_t {
+		std::uint32_t at = strings;
+		std::memcpy(block + at, str.data(), str.size());
+		strings += static_cast<std::uint32_t>(str.size() + 1);
+		return rva + at;
+	};
+
+	Directory_t* directory = reinterpret_cast<Directory_t*>(block);
+	directory->Characteristics = header.Characteristics;
+	directory->TimeDateStamp = header.TimeDateStamp;
+	directory->MajorVersion = header.MajorVersion;
+	directory->MinorVersion = header.MinorVersion;
+	directory->Name = writeString(moduleName);
+	directory->Base = base;
+	directory->NumberOfFunctions = count;
+	directory->NumberOfNames = static_cast<std::uint32_t>(names.size());
+	directory->AddressOfFunctions = rva + functionsOffset;
+	directory->AddressOfNames = rva + namesOffset;
+	directory->AddressOfNameOrdinals = rva + ordinalsOffset;
+
+	std::uint32_t* functionTable = reinterpret_cast<std::uint32_t*>(block + functionsOffset);
+	std::uint32_t* nameTable = reinterpret_cast<std::uint32_t*>(block + namesOffset);
+	std::uint16_t* ordinalTable = reinterpret_cast<std::uint16_t*>(block + ordinalsOffset);
+
+	std::size_t n = 0;
+	for (auto const& [name, ordinal] : names)
+	{
+		nameTable[n] = writeString(name);
+		ordinalTable[n] = static_cast<std::uint16_t>(ordinal - base);
+		n++;
+	}
+
+	for (auto const& [ordinal, function] : functions)
+		functionTable[ordinal - base] = function.forwarder.empty() ? function.rva : writeString(function.forwarder);
+
+	//
+	// 5) Point the directory at the block, it covers the forwarder strings. A previous block we placed ourselves goes back to the free space.
+	IMAGE_DATA_DIRECTORY& newDir = m_image->getPEHdr().getOptionalHdr().getDataDir(DIRECTORY_ENTRY_EXPORT);
+
+	newDir.VirtualAddress = rva;
+	newDir.Size = size;
+
+	m_image->releaseInSection(section_name, oldOffset, oldDir.Size);
+
+	exports._setup(m_image);
+	return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+namespace pepp
+{
+	///
+	// - class ExportBuilder
+	// - Collects exports to add to an image and writes a complete new export directory in one pass:
+	// - the directory, function table, sorted name table, name ordinal table and every string
+	// - (module name, export names, forwarders), sized exactly and placed as one block.
+	// - Existing exports are carried over. The block goes into free space of a section named
+	// - `section_name` if one has room, otherwise a new section of that name is appended.
+	///
+	template<unsigned int bitsize>
+	class ExportBuilder : pepp::msc::NonCopyable
+	{
+		struct Entry_t
+		{
+			//! Empty for exports by ordinal only
+			std::string		name;
+			std::uint32_t	rva;
+			//! "dll.function" or "dll.#ordinal", exported instead of an rva if not empty
+			std::string		forwarder;
+			//! 0 to take the next free ordinal
+			std::uint32_t	ordinal;
+		};
+
+		Image<bitsize>*			m_image;
+		std::vector<Entry_t>	m_entries;
+		std::string				m_moduleName;
+	public:
+		explicit ExportBuilder(Image<bitsize>& image);
+
+		//! Queue an export, `name` may be empty to export by ordinal only (then `ordinal` has to be set).
+		//! A name the image already exports is replaced.
+		void add(std::string_view name, std::uint32_t rva, std::uint32_t ordinal = 0);
+
+		//! Queue a forwarded export, e.g addForwarder("HeapAlloc", "NTDLL.RtlAllocateHeap")
+		void addForwarder(std::string_view name, std::string_view forwarder, std::uint32_t ordinal = 0);
+
+		//! Module name written in the directory, defaults to the existing one
+		void setModuleName(std::string_view name) {
+			m_moduleName = name;
+		}
+
+		//! Write the new export directory. Fails (leaving the image untouched) if an explicit ordinal
+		//! is already taken by another export, or the ordinal range doesn't fit the tables.
+		bool build(std::string_view section_name = ".pepp");
+
+		//! Number of queued exports
+		std::size_t size() const noexcept {
+			return m_entries.size();
+		}
+
+		void clear() {
+			m_entries.clear();
+		}
+	};
+}
@@ -20,21 +20,24 @@ ExportData_t ExportDirectory<bitsize>::getExport(std::uint32_t idx, bool demangl
 		mem::ByteVector const* buffer{};
 
 		funcOrdinals = m_image->getPEHdr().rvaToOffset(getAddressOfNameOrdinals());
-		uint16_t rlIdx = m_image->buffer().deref<uint16_t>(funcOrdinals + (idx * sizeof uint16_t));
+		uint16_t rlIdx = m_image->view().deref<uint16_t>(funcOrdinals + (idx * sizeof uint16_t));
 
 		funcAddresses = m_image->getPEHdr().rvaToOffset(getAddressOfFunctions() + sizeof(std::uint32_t) * rlIdx);
 		funcNames = m_image->getPEHdr().rvaToOffset(getAddressOfNames() + sizeof(std::uint32_t) * idx);
-		funcNamesOffset = m_image->getPEHdr().rvaToOffset(m_image->buffer().deref<uint32_t>(funcNames));
+		funcNamesOffset = m_image->getPEHdr().rvaToOffset(m_image->view().deref<uint32_t>(funcNames));
 
 
 		if (funcAddresses && funcNames && funcOrdinals)
 		{
+			std::uint32_t rva = m_image->view().deref<uint32_t>(funcAddresses);
+
 			return 
 			{
-				   demangle ? DemangleName(m_image->buffer().as<char*>(funcNamesOffset)) : m_image->buffer().as<char*>(funcNamesOffset),
-				   m_image->buffer().deref<uint32_t>(funcAddresses),
+				   demangle ? m_demangleCache.get(m_image->view().deref<uint32_t>(funcNames), m_image->view().as<char*>(funcNamesOffset)) : m_image->view().as<char*>(funcNamesOffset),
+				   rva,
 				   m_base->Base + idx,
-				   rlIdx
+				   rlIdx,
+				   std::string(getForwarder(rva))
 			};
 		}
 	}
@@ -45,18 +48,65 @@ ExportData_t ExportDirectory<bitsize>::getExport(std::uint32_t idx, bool demangl
 template<unsigned int bitsize>
 ExportData_t pepp::ExportDirectory<bitsize>::getExport(std::string_view name, bool demangle) const
 {
-	for (int i = 0; i < getNumberOfNames(); i++)
-	{
-		ExportData_t data = getExport(i, demangle);
-		if (data.name == name)
-			return data;
-	}
+	// A miss stays a binary search, demangled names are only looked up through findDemangledNameIndex().
+	std::uint32_t idx = findNameIndex(name);
+	return idx != EXPORT_NOT_FOUND ? getExport(idx, demangle) : ExportData_t{};
+}
 
-	return {};
+template<unsigned int bitsize>
+bool ExportDirectory<bitsize>::findExport(std::string_view name, ExportEntry_t& out) const
+{
+	std::uint32_t idx = findNameIndex(name);
+	if (idx == EXPORT_NOT_FOUND)
+		return false;
+
+	std::uint16_t function = getNameOrdinal(idx);
+	std::uint32_t offset = m_image->getPEHdr().rvaToOffset(getAddressOfFunctions() + sizeof(std::uint32_t) * function);
+
+	if (offset == 0 || offset + sizeof(std::uint32_t) > m_image->view().size())
+		return false;
+
+	out.name = getName(idx);
+	out.rva = m_image->view().deref<std::uint32_t>(offset);
+	out.ordinal = getBase() + function;
+	out.name_index = idx;
+	out.function_index = function;
+	out.forwarder = getForwarder(out.rva);
+	return true;
+}
+
+template<unsigned int bitsize>
+std::uint32_t ExportDirectory<bitsize>::findDemangledNameIndex(std::string_view name) const
+{
+	if (!isPresent())
+		return EXPORT_NOT_FOUND;
+
+	_buildDemangledIndex();
+
+	auto it = m_demangledIndex.find(name);
+	return it != m_demangledIndex.end() ? it->second : EXPORT_NOT_FOUND;
+}
+
+template<unsigned int bitsize>
+void ExportDirectory<bitsize>::_buildDemangledIndex() const
+{
+	if (m_demangledBuilt.load(std::memory_order_acquire))
+		return;
+
+	std::lock_guard<std::mutex> lock(m_demangledLock);
+
+	if (m_demangledBuilt.load(std::memory_order_relaxed))
+		return;
+
+	// The first name demangling to a string wins, like the linear search did.
+	for (std::uint32_t i = 0; i < getNumberOfNames(); i++)
+		m_demangledIndex.try_emplace(m_demangleCache.get(_getNameRva(i), getName(i)), i);
+
+	m_demangledBuilt.store(true, std::memory_order_release);
 }
 
 template<unsigned int bitsize>
-void ExportDirectory<bitsize>::traverseExports(const std::function<void(ExportData_t*)>& cb_func, bool demangle)
+void ExportDirectory<bitsize>::traverseExports(const std::function<void(ExportData_t*)>& cb_func, bool demangle) const
 {
 	for (int i = 0; i < getNumberOfNames(); i++)
 	{
@@ -73,7 +123,124 @@ bool ExportDirectory<bitsize>::isPresent() const noexcept
 }
 
 template<unsigned int bitsize>
-void ExportDirectory<bitsize>::add(std::string_view name, std::uint32_t rva)
+std::uint32_t ExportDirectory<bitsize>::_getNameRva(std::uint32_t idx) const
+{
+	std::uint32_t entry = m_image->getPEHdr().rvaToOffset(getAddressOfNames() + sizeof(std::uint32_t) * idx);
+
+	if (entry == 0 || entry + sizeof(std::uint32_t) > m_image->view().size())
+		return 0;
+
+	return m_image->view().deref<std::uint32_t>(entry);
+}
+
+template<unsigned int bitsize>
+std::string_view ExportDirectory<bitsize>::getName(std::uint32_t idx) const
 {
-	// TODO
+	mem::ByteView const& buffer = m_image->view();
+	std::uint32_t rva = _getNameRva(idx);
+
+	if (rva == 0)
+		return {};
+
+	std::uint32_t offset = m_image->getPEHdr().rvaToOffset(rva);
+	if (offset == 0 || offset >= buffer.size())
+		return {};
+
+	const char* name = buffer.as<const char*>(offset);
+	return std::string_view(name, strnlen(name, buffer.size() - offset));
+}
+
+template<unsigned int bitsize>
+std::uint32_t ExportDirectory<bitsize>::getFunctionRva(std::uint32_t function_index) const
+{
+	std::uint32_t offset = m_image->getPEHdr().rvaToOffset(getAddressOfFunctions() + sizeof(std::uint32_t) * function_index);
+
+	if (offset == 0 || offset + sizeof(std::uint32_t) > m_image->view().size())
+		return 0;
+
+	return m_image->view().deref<std::uint32_t>(offset);
+}
+
+template<unsigned int bitsize>
+bool ExportDirectory<bitsize>::isForwarder(std::uint32_t rva) const noexcept
+{
+	IMAGE_DATA_DIRECTORY const& dir = m_image->getPEHdr().getOptionalHdr().getDataDir(DIRECTORY_ENTRY_EXPORT);
+	return rva >= dir.VirtualAddress && rva - dir.VirtualAddress < dir.Size;
+}
+
+template<unsigned int bitsize>
+std::string_view ExportDirectory<bitsize>::getForwarder(std::uint32_t rva) const
+{
+	if (!isForwarder(rva))
+		return {};
+
+	mem::ByteView const& buffer = m_image->view();
+	std::uint32_t offset = m_image->getPEHdr().rvaToOffset(rva);
+
+	if (offset == 0 || offset >= buffer.size())
+		return {};
+
+	const char* forwarder = buffer.as<const char*>(offset);
+	return std::string_view(forwarder, strnlen(forwarder, buffer.size() - offset));
+}
+
+template<unsigned int bitsize>
+std::string_view ExportDirectory<bitsize>::getModuleName() const
+{
+	mem::ByteView const& buffer = m_image->view();
+	std::uint32_t offset = isPresent() ? m_image->getPEHdr().rvaToOffset(m_base->Name) : 0;
+
+	if (offset == 0 || offset >= buffer.size())
+		return {};
+
+	const char* name = buffer.as<const char*>(offset);
+	return std::string_view(name, strnlen(name, buffer.size() - offset));
+}
+
+template<unsigned int bitsize>
+std::uint16_t ExportDirectory<bitsize>::getNameOrdinal(std::uint32_t idx) const
+{
+	std::uint32_t offset = m_image->getPEHdr().rvaToOffset(getAddressOfNameOrdinals() + sizeof(std::uint16_t) * idx);
+
+	if (offset == 0 || offset + sizeof(std::uint16_t) > m_image->view().size())
+		return 0;
+
+	return m_image->view().deref<std::uint16_t>(offset);
+}
+
+template<unsigned int bitsize>
+std::uint32_t ExportDirectory<bitsize>::findNameIndex(std::string_view name) const
+{
+	if (!isPresent())
+		return EXPORT_NOT_FOUND;
+
+	//
+	// Names are sorted by plain byte compare (the loader relies on it), same as string_view's.
+	std::uint32_t lo = 0;
+	std::uint32_t hi = getNumberOfNames();
+
+	while (lo < hi)
+	{
+		std::uint32_t mid = lo + (hi - lo) / 2;
+		int cmp = getName(mid).compare(name);
+
+		if (cmp == 0)
+			return mid;
+
+		if (cmp < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return EXPORT_NOT_FOUND;
+}
+
+template<unsigned int bitsize>
+bool ExportDirectory<bitsize>::add(std::string_view name, std::uint32_t rva)
+{
+	ExportBuilder<bitsize> builder(*m_image);
+	builder.add(name, rva);
+
+	return builder.build();
 }
@@ -1,32 +1,113 @@
 #pragma once
 
 #include <functional>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
 
 namespace pepp
 {
+	//! Returned by export name lookups that don't find the name
+	static constexpr std::uint32_t EXPORT_NOT_FOUND = 0xffffffff;
+
 	struct ExportData_t
 	{
 		std::string name{};
 		std::uint32_t rva = 0;
 		std::uint32_t base_ordinal = 0xffffffff;
 		std::uint32_t name_ordinal = 0xffffffff;
+		//! "dll.function" if the export is forwarded, rva then points at this string
+		std::string forwarder{};
 	};
 
+	//! Export found by ExportDirectory::findExport, the name points into the image buffer
+	struct ExportEntry_t
+	{
+		std::string_view name{};
+		std::uint32_t rva = 0;
+		//! Base + function_index
+		std::uint32_t ordinal = 0;
+		std::uint32_t name_index = EXPORT_NOT_FOUND;
+		//! Index into AddressOfFunctions
+		std::uint16_t function_index = 0;
+		//! "dll.function" if the export is forwarded, points into the image buffer
+		std::string_view forwarder{};
+	};
+
+	namespace detail
+	{
+		//! Lets maps keyed by std::string be searched with a std::string_view
+		struct TransparentStringHash_t
+		{
+			using is_transparent = void;
+
+			std::size_t operator()(std::string_view str) const noexcept {
+				return std::hash<std::string_view>{}(str);
+			}
+		};
+	}
+
+	template<unsigned int bitsize>
+	class ExportBuilder;
+
 	template<unsigned int bitsize>
 	class ExportDirectory : public pepp::msc::NonCopyable
 	{
 		friend class Image<32>;
 		friend class Image<64>;
+		friend class ExportBuilder<bitsize>;
 
 		Image<bitsize>*							m_image;
 		detail::Image_t<>::ExportDirectory_t	*m_base;
+		//! Demangled name -> name index, only built by findDemangledNameIndex()
+		mutable std::unordered_map<std::string, std::uint32_t, detail::TransparentStringHash_t, std::equal_to<>> m_demangledIndex;
+		mutable std::atomic<bool>				m_demangledBuilt{ false };
+		mutable std::mutex						m_demangledLock;
+		//! Demangled names by name rva, shared by getExport/traverseExports and the demangled index
+		mutable DemangleCache					m_demangleCache;
 	public:
 		ExportData_t getExport(std::uint32_t idx, bool demangle = true) const;
+		//! Binary search for the raw (mangled) `name`, `demangle` only affects the name returned.
+		//! Use findDemangledNameIndex() + getExport(idx) to look an export up by its demangled name.
 		ExportData_t getExport(std::string_view name, bool demangle = true) const;
-		void add(std::string_view name, std::uint32_t rva);
-		void traverseExports(const std::function<void(ExportData_t*)>& cb_func, bool demangle = true);
+		//! Single ExportBuilder pass, use ExportBuilder directly to add many exports at once
+		bool add(std::string_view name, std::uint32_t rva);
+		void traverseExports(const std::function<void(ExportData_t*)>& cb_func, bool demangle = true) const;
 		bool isPresent() const noexcept;
 
+		//! Index of `name` in the export name table (binary search, the table is sorted), or EXPORT_NOT_FOUND.
+		//! This is the hint the loader checks before searching the table itself.
+		std::uint32_t findNameIndex(std::string_view name) const;
+
+		//! Binary search for the raw (mangled) `name`, without allocating. False if it isn't exported by name.
+		bool findExport(std::string_view name, ExportEntry_t& out) const;
+
+		//! Name index of the export whose demangled name is `name`, or EXPORT_NOT_FOUND.
+		//! Demangles every export name once, on the first call.
+		std::uint32_t findDemangledNameIndex(std::string_view name) const;
+
+		//! Name table entry `idx` -> index into AddressOfFunctions (ordinal - Base)
+		std::uint16_t getNameOrdinal(std::uint32_t idx) const;
+
+		//! Name of name table entry `idx`, points into the image buffer
+		std::string_view getName(std::uint32_t idx) const;
+
+		//! Function table entry `function_index` (ordinal - Base), 0 for gaps or if the table can't be read
+		std::uint32_t getFunctionRva(std::uint32_t function_index) const;
+
+		//! Does an export rva point at a forwarder string? (it lies inside the export directory then)
+		bool isForwarder(std::uint32_t rva) const noexcept;
+
+		//! Forwarder string an export rva points at, empty if the export isn't forwarded
+		std::string_view getForwarder(std::uint32_t rva) const;
+
+		//! Name the module gives itself, points into the image buffer
+		std::string_view getModuleName() const;
+
+		std::uint32_t getBase() const {
+			return m_base->Base;
+		}
+
 		void setNumberOfFunctions(std::uint32_t num) {
 			m_base->NumberOfFunctions = num;
 		}
@@ -89,8 +170,22 @@ namespace pepp
 		}
 
 	private:
+		//! Build m_demangledIndex if it isn't already, safe to call from several threads
+		void _buildDemangledIndex() const;
+
+		//! Rva of name table entry `idx`, 0 if the table can't be read
+		std::uint32_t _getNameRva(std::uint32_t idx) const;
+
+		void _resetDemangledIndex() {
+			std::lock_guard<std::mutex> lock(m_demangledLock);
+			m_demangledIndex.clear();
+			m_demangledBuilt.store(false, std::memory_order_release);
+		}
+
 		//! Setup the directory
 		void _setup(Image<bitsize>* image) {
+			_resetDemangledIndex();
+			m_demangleCache.clear();
 			m_image = image;
 			m_base = reinterpret_cast<decltype(m_base)>(
 				&image->base()[image->getPEHdr().rvaToOffset(
@@ -0,0 +1,165 @@
+#include "PELibrary.hpp"
+
+#include <charconv>
+
+using namespace pepp;
+
+// Explicit templates.
+template class ExportResolver<32>;
+template class ExportResolver<64>;
+
+template<unsigned int bitsize>
+void ExportResolver<bitsize>::addModule(std::string_view name, const Image<bitsize>& image)
+{
+	std::string stem = _getStem(name);
+	std::string_view file = name.substr(name.find_last_of("\\/") + 1);
+
+	m_modules.insert_or_assign(stem, Module_t{ &image, std::string(file) });
+	clearCache();
+}
+
+template<unsigned int bitsize>
+void ExportResolver<bitsize>::addAlias(std::string_view alias, std::string_view target)
+{
+	m_aliases.insert_or_assign(_getStem(alias), _getStem(target));
+	clearCache();
+}
+
+template<unsigned int bitsize>
+bool ExportResolver<bitsize>::resolve(std::string_view module, std::string_view name, Resolved_t& out) const
+{
+	std::string stem = _getStem(module);
+	std::vector<std::string> keys;
+	Resolved_t result{};
+
+	for (std::uint32_t hop = 0; hop < max_forwarder_hops; hop++)
+	{
+		std::string key = stem;
+		key += '!';
+		key += name;
+
+		{
+			std::shared_lock<std::shared_mutex> lock(m_cacheLock);
+
+			auto it = m_cache.find(key);
+			if (it != m_cache.end())
+			{
+				result = it->second;
+				break;
+			}
+		}
+
+		keys.push_back(std::move(key));
+
+		std::string_view forwarder;
+		if (!_lookup(stem, name, result, forwarder))
+			break;
+
+		if (forwarder.empty())
+			break;
+
+		//
+		// "module.function", the module name may itself contain dots (API sets never end in one).
+		std::size_t dot = forwarder.rfind('.');
+		if (dot == std::string_view::npos || dot == 0 || dot + 1 == forwarder.size())
+			break;
+
+		stem = _getStem(forwarder.substr(0, dot));
+		name = forwarder.substr(dot + 1);
+	}
+
+	//
+	// Every step of the chain resolves to the same export. A chain that ran out of hops is a cycle, a miss.
+	{
+		std::unique_lock<std::shared_mutex> lock(m_cacheLock);
+
+		for (std::string& key : keys)
+			m_cache.emplace(std::move(key), result);
+	}
+
+	out = result;
+	return result.image != nullptr;
+}
+
+template<unsigned int bitsize>
+bool ExportResolver<bitsize>::resolve(std::string_view module, std::uint32_t ordinal, Resolved_t& out) const
+{
+	std::string name = "#" + std::to_string(ordinal);
+	return resolve(module, name, out);
+}
+
+template<unsigned int bitsize>
+void ExportResolver<bitsize>::clearCache()
+{
+	std::unique_lock<std::shared_mutex> lock(m_cacheLock);
+	m_cache.clear();
+}
+
+template<unsigned int bitsize>
+std::string ExportResolver<bitsize>::_getStem(std::string_view name)
+{
+	name = name.substr(name.find_last_of("\\/") + 1);
+
+	std::string stem(name);
+	for (char& c : stem)
+	{
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+	}
+
+	if (stem.size() > 4 && stem.compare(stem.size() - 4, 4, ".dll") == 0)
+		stem.resize(stem.size() - 4);
+
+	return stem;
+}
+
+template<unsigned int bitsize>
+bool ExportResolver<bitsize>::_lookup(const std::string& stem, std::string_view name, Resolved_t& out, std::string_view& forwarder) const
+{
+	out = {};
+	forwarder = {};
+
+	auto alias = m_aliases.find(stem);
+	auto it = m_modules.find(alias != m_aliases.end() ? alias->second : stem);
+
+	if (it == m_modules.end())
+		return false;
+
+	const ExportDirectory<bitsize>& exports = it->second.image->getExportDir();
+	if (!exports.isPresent() || name.empty())
+		return false;
+
+	std::uint32_t rva = 0;
+
+	if (name[0] == '#')
+	{
+		std::uint32_t ordinal = 0;
+		auto [end, ec] = std::from_chars(name.data() + 1, name.data() + name.size(), ordinal);
+
+		if (ec != std::errc() || end != name.data() + name.size() || ordinal < exports.getBase())
+			return false;
+
+		std::uint32_t function = ordinal - exports.getBase();
+		if (function >= exports.getNumberOfFunctions())
+			return false;
+
+		rva = exports.getFunctionRva(function);
+	}
+	else
+	{
+		ExportEntry_t entry;
+		if (!exports.findExport(name, entry))
+			return false;
+
+		rva = entry.rva;
+	}
+
+	if (rva == 0)
+		return false;
+
+	forwarder = exports.getForwarder(rva);
+	if (forwarder.empty())
+		out = { it->second.image, it->second.name, rva };
+
+	return true;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <shared_mutex>
+
+namespace pepp
+{
+	///
+	// - class ExportResolver
+	// - Resolves exports across a set of loaded images, following forwarders ("NTDLL.RtlAllocateHeap",
+	// - "MOD.#12") and aliases (API sets) to the module and rva that actually hold the code.
+	// - Every (module, name) met on the way is memoized, misses included, so repeated lookups are a single hash.
+	// - Modules are matched case insensitively, without the ".dll" extension. The images must outlive the resolver.
+	///
+	template<unsigned int bitsize>
+	class ExportResolver : pepp::msc::NonCopyable
+	{
+	public:
+		struct Resolved_t
+		{
+			const Image<bitsize>*	image = nullptr;
+			//! Name the module was added under, points into the resolver
+			std::string_view		module{};
+			std::uint32_t			rva = 0;
+		};
+
+		//! Forwarder chains longer than this are treated as cycles
+		static constexpr std::uint32_t max_forwarder_hops = 32;
+
+	private:
+		struct Module_t
+		{
+			const Image<bitsize>*	image;
+			std::string				name;
+		};
+
+		using Map_t = std::unordered_map<std::string, Module_t, detail::TransparentStringHash_t, std::equal_to<>>;
+
+		//! Lowercase stem -> module
+		Map_t																						m_modules;
+		//! Lowercase stem -> lowercase stem of the module it stands for
+		std::unordered_map<std::string, std::string, detail::TransparentStringHash_t, std::equal_to<>>	m_aliases;
+		//! "stem!name" -> final export, image is null for exports that don't resolve
+		mutable std::unordered_map<std::string, Resolved_t, detail::TransparentStringHash_t, std::equal_to<>> m_cache;
+		mutable std::shared_mutex																	m_cacheLock;
+	public:
+		ExportResolver() = default;
+
+		//! Add (or replace) a module, `name` may be a file name or path ("C:\\Windows\\System32\\kernel32.dll").
+		//! Clears the cache.
+		void addModule(std::string_view name, const Image<bitsize>& image);
+
+		//! Resolve `alias` (e.g an API set, "api-ms-win-core-heap-l1-1-0") as `target`. Clears the cache.
+		void addAlias(std::string_view alias, std::string_view target);
+
+		//! Follow `module`!`name` to the export that isn't forwarded. `name` may be "#ordinal".
+		//! False if a module along the way isn't loaded, the export doesn't exist, or the chain loops.
+		bool resolve(std::string_view module, std::string_view name, Resolved_t& out) const;
+
+		//! Same as resolve(module, "#ordinal", out)
+		bool resolve(std::string_view module, std::uint32_t ordinal, Resolved_t& out) const;
+
+		//! Number of loaded modules
+		std::size_t size() const noexcept {
+			return m_modules.size();
+		}
+
+		void clearCache();
+
+	private:
+		//! Lowercase file name without the directory and ".dll"
+		static std::string _getStem(std::string_view name);
+
+		//! Single hop: the export `name` of the module `stem`, no cache. Sets `forwarder` instead of `out` when forwarded.
+		bool _lookup(const std::string& stem, std::string_view name, Resolved_t& out, std::string_view& forwarder) const;
+	};
+}
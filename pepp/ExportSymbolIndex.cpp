@@ -0,0 +1,162 @@
+#include "PELibrary.hpp"
+
+using namespace pepp;
+
+namespace
+{
+	// "PXSI"
+	constexpr std::uint32_t index_magic = 0x49535850;
+	constexpr std::uint32_t index_version = 1;
+	// magic, version, module name size, symbol count, strings size
+	constexpr std::size_t header_size = 5 * sizeof(std::uint32_t);
+	constexpr std::size_t symbol_size = 4 * sizeof(std::uint32_t);
+
+	void put32(std::vector<std::uint8_t>& out, std::uint32_t value)
+	{
+		for (int i = 0; i < 4; i++)
+			out.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+	}
+
+	std::uint32_t get32(const std::uint8_t* data)
+	{
+		return static_cast<std::uint32_t>(data[0]) | (static_cast<std::uint32_t>(data[1]) << 8) |
+			(static_cast<std::uint32_t>(data[2]) << 16) | (static_cast<std::uint32_t>(data[3]) << 24);
+	}
+}
+
+template<unsigned int bitsize>
+void ExportSymbolIndex::build(const Image<bitsize>& image)
+{
+	clear();
+
+	const ExportDirectory<bitsize>& exports = image.getExportDir();
+	if (!exports.isPresent())
+		return;
+
+	// A function table can't be larger than the file it is in.
+	const std::uint32_t count = static_cast<std::uint32_t>((std::min)(static_cast<std::size_t>(exports.getNumberOfFunctions()), image.view().size() / sizeof(std::uint32_t)));
+
+	m_strings = exports.getModuleName();
+	m_moduleNameSize = static_cast<std::uint32_t>(m_strings.size());
+
+	//
+	// First name of every function.
+	std::vector<std::uint32_t> names(count, EXPORT_NOT_FOUND);
+
+	for (std::uint32_t i = 0; i < exports.getNumberOfNames(); i++)
+	{
+		std::uint16_t function = exports.getNameOrdinal(i);
+		if (function < count && names[function] == EXPORT_NOT_FOUND)
+			names[function] = i;
+	}
+
+	for (std::uint32_t function = 0; function < count; function++)
+	{
+		std::uint32_t rva = exports.getFunctionRva(function);
+
+		// Gaps, and forwarders
+		if (rva == 0 || exports.isForwarder(rva))
+			continue;
+
+		std::string_view name = names[function] != EXPORT_NOT_FOUND ? exports.getName(names[function]) : std::string_view{};
+
+		m_symbols.push_back({ rva, exports.getBase() + function, static_cast<std::uint32_t>(m_strings.size()), static_cast<std::uint32_t>(name.size()) });
+		m_strings += name;
+	}
+
+	//
+	// One symbol per rva, named ones win over exports by ordinal only.
+	std::sort(m_symbols.begin(), m_symbols.end(), [](const Symbol_t& lhs, const Symbol_t& rhs) {
+		if (lhs.rva != rhs.rva)
+			return lhs.rva < rhs.rva;
+		if ((lhs.name_size != 0) != (rhs.name_size != 0))
+			return lhs.name_size != 0;
+		return lhs.ordinal < rhs.ordinal;
+	});
+
+	m_symbols.erase(std::unique(m_symbols.begin(), m_symbols.end(),
+		[](const Symbol_t& lhs, const Symbol_t& rhs) { return lhs.rva == rhs.rva; }), m_symbols.end());
+}
+
+// Explicit templates (after the definition, which they need).
+template void ExportSymbolIndex::build<32>(const Image<32>& image);
+template void ExportSymbolIndex::build<64>(const Image<64>& image);
+
+bool ExportSymbolIndex::lookupNearest(std::uint32_t rva, ExportSymbol_t& symbol, std::uint32_t& displacement) const
+{
+	auto it = std::upper_bound(m_symbols.begin(), m_symbols.end(), rva,
+		[](std::uint32_t rva, const Symbol_t& symbol) { return rva < symbol.rva; });
+
+	if (it == m_symbols.begin())
+		return false;
+
+	--it;
+	symbol = getSymbol(static_cast<std::size_t>(it - m_symbols.begin()));
+	displacement = rva - it->rva;
+	return true;
+}
+
+void ExportSymbolIndex::clear()
+{
+	m_symbols.clear();
+	m_strings.clear();
+	m_moduleNameSize = 0;
+}
+
+std::vector<std::uint8_t> ExportSymbolIndex::serialize() const
+{
+	std::vector<std::uint8_t> out;
+	out.reserve(header_size + m_symbols.size() * symbol_size + m_strings.size());
+
+	put32(out, index_magic);
+	put32(out, index_version);
+	put32(out, m_moduleNameSize);
+	put32(out, static_cast<std::uint32_t>(m_symbols.size()));
+	put32(out, static_cast<std::uint32_t>(m_strings.size()));
+
+	for (const Symbol_t& symbol : m_symbols)
+	{
+		put32(out, symbol.rva);
+		put32(out, symbol.ordinal);
+		put32(out, symbol.name_offset);
+		put32(out, symbol.name_size);
+	}
+
+	out.insert(out.end(), m_strings.begin(), m_strings.end());
+	return out;
+}
+
+bool ExportSymbolIndex::deserialize(std::span<const std::uint8_t> data)
+{
+	clear();
+
+	if (data.size() < header_size || get32(&data[0]) != index_magic || get32(&data[4]) != index_version)
+		return false;
+
+	const std::uint32_t moduleNameSize = get32(&data[8]);
+	const std::uint64_t count = get32(&data[12]);
+	const std::uint64_t stringsSize = get32(&data[16]);
+
+	if (data.size() != header_size + count * symbol_size + stringsSize || moduleNameSize > stringsSize)
+		return false;
+
+	std::vector<Symbol_t> symbols(static_cast<std::size_t>(count));
+	const std::uint8_t* entry = data.data() + header_size;
+
+	for (Symbol_t& symbol : symbols)
+	{
+		symbol = { get32(entry), get32(entry + 4), get32(entry + 8), get32(entry + 12) };
+		entry += symbol_size;
+
+		// Names inside the strings, rvas strictly ascending (lookups rely on it).
+		if (static_cast<std::uint64_t>(symbol.name_offset) + symbol.name_size > stringsSize)
+			return false;
+		if (&symbol != symbols.data() && (&symbol)[-1].rva >= symbol.rva)
+			return false;
+	}
+
+	m_symbols = std::move(symbols);
+	m_strings.assign(reinterpret_cast<const char*>(entry), static_cast<std::size_t>(stringsSize));
+	m_moduleNameSize = moduleNameSize;
+	return true;
+}
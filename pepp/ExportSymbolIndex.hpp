@@ -0,0 +1,76 @@
+#pragma once
+
+namespace pepp
+{
+	//! One export of an ExportSymbolIndex, the name points into the index
+	struct ExportSymbol_t
+	{
+		std::uint32_t		rva;
+		std::uint32_t		ordinal;
+		//! Empty for exports by ordinal only
+		std::string_view	name;
+	};
+
+	///
+	// - class ExportSymbolIndex
+	// - A module's exports sorted by rva, to symbolize addresses as module!export+displacement.
+	// - Forwarders are left out (they have no code). One export is kept per rva: a named one, the lowest ordinal on ties.
+	// - Independent of the image once built, and serializable so it can be cached (e.g by module hash).
+	///
+	class ExportSymbolIndex
+	{
+		struct Symbol_t
+		{
+			std::uint32_t	rva;
+			std::uint32_t	ordinal;
+			//! Name in m_strings
+			std::uint32_t	name_offset;
+			std::uint32_t	name_size;
+		};
+
+		std::vector<Symbol_t>	m_symbols;
+		//! Module name followed by the export names
+		std::string				m_strings;
+		std::uint32_t			m_moduleNameSize = 0;
+	public:
+		ExportSymbolIndex() = default;
+
+		template<unsigned int bitsize>
+		explicit ExportSymbolIndex(const Image<bitsize>& image) {
+			build(image);
+		}
+
+		template<unsigned int bitsize>
+		void build(const Image<bitsize>& image);
+
+		//! Closest export at or below `rva`, `displacement` = rva - symbol.rva.
+		//! False if `rva` lies below every export.
+		bool lookupNearest(std::uint32_t rva, ExportSymbol_t& symbol, std::uint32_t& displacement) const;
+
+		std::string_view getModuleName() const {
+			return std::string_view(m_strings.data(), m_moduleNameSize);
+		}
+
+		std::size_t size() const noexcept {
+			return m_symbols.size();
+		}
+
+		bool empty() const noexcept {
+			return m_symbols.empty();
+		}
+
+		//! Symbol `idx` in rva order
+		ExportSymbol_t getSymbol(std::size_t idx) const {
+			const Symbol_t& symbol = m_symbols[idx];
+			return { symbol.rva, symbol.ordinal, std::string_view(m_strings.data() + symbol.name_offset, symbol.name_size) };
+		}
+
+		void clear();
+
+		//! Flat little endian form, for caching
+		std::vector<std::uint8_t> serialize() const;
+
+		//! Load what serialize() produced, false (and an empty index) if `data` isn't a valid index
+		bool deserialize(std::span<const std::uint8_t> data);
+	};
+}
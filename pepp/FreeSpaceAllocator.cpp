@@ -0,0 +1,132 @@
+#include "PELibrary.hpp"
+
+using namespace pepp;
+
+void FreeSpaceAllocator::build(const std::uint8_t* data, std::uint32_t begin, std::uint32_t end, std::uint8_t value, std::size_t min_run)
+{
+	m_runs.clear();
+	m_begin = begin;
+	m_end = end;
+	m_value = value;
+
+	for (auto const& run : PaddingRuns(data, begin, end, value, min_run))
+		m_runs.push_back(run);
+}
+
+std::uint32_t FreeSpaceAllocator::allocate(std::size_t size, std::uint32_t alignment)
+{
+	if (size == 0)
+		return NO_FREE_SPACE;
+
+	//
+	// First fit, the lowest offset wins (what a forward padding scan would return).
+	for (auto it = m_runs.begin(); it != m_runs.end(); ++it)
+	{
+		const std::uint64_t runEnd = static_cast<std::uint64_t>(it->offset) + it->size;
+		const std::uint64_t start = align(static_cast<std::uint64_t>(it->offset), alignment);
+
+		if (start + size > runEnd)
+			continue;
+
+		const std::uint32_t offset = static_cast<std::uint32_t>(start);
+		const std::uint32_t tail = static_cast<std::uint32_t>(runEnd - (start + size));
+
+		//
+		// The run may be split in two by the alignment gap.
+		if (offset != it->offset)
+		{
+			it->size = offset - it->offset;
+			if (tail != 0)
+				m_runs.insert(it + 1, { static_cast<std::uint32_t>(start + size), tail });
+		}
+		else if (tail != 0)
+		{
+			it->offset += static_cast<std::uint32_t>(size);
+			it->size = tail;
+		}
+		else
+		{
+			m_runs.erase(it);
+		}
+
+		return offset;
+	}
+
+	return NO_FREE_SPACE;
+}
+
+void FreeSpaceAllocator::reserve(std::uint32_t offset, std::size_t size)
+{
+	const std::uint64_t end = static_cast<std::uint64_t>(offset) + size;
+	std::vector<Run_t> runs;
+
+	runs.reserve(m_runs.size() + 1);
+
+	for (const Run_t& run : m_runs)
+	{
+		const std::uint64_t runEnd = static_cast<std::uint64_t>(run.offset) + run.size;
+
+		if (runEnd <= offset || run.offset >= end)
+		{
+			runs.push_back(run);
+			continue;
+		}
+
+		// Keep the parts on either side of the reserved range.
+		if (run.offset < offset)
+			runs.push_back({ run.offset, offset - run.offset });
+		if (runEnd > end)
+			runs.push_back({ static_cast<std::uint32_t>(end), static_cast<std::uint32_t>(runEnd - end) });
+	}
+
+	m_runs = std::move(runs);
+}
+
+void FreeSpaceAllocator::free(std::uint32_t offset, std::size_t size)
+{
+	if (size == 0)
+		return;
+
+	// Don't double count anything that is already free.
+	reserve(offset, size);
+
+	auto it = std::lower_bound(m_runs.begin(), m_runs.end(), offset,
+		[](const Run_t& run, std::uint32_t offset) { return run.offset < offset; });
+
+	it = m_runs.insert(it, { offset, static_cast<std::uint32_t>(size) });
+
+	//
+	// Merge with the neighbours.
+	if (auto next = it + 1; next != m_runs.end() && it->offset + it->size == next->offset)
+	{
+		it->size += next->size;
+		m_runs.erase(next);
+	}
+
+	if (it != m_runs.begin())
+	{
+		auto prev = it - 1;
+		if (prev->offset + prev->size == it->offset)
+		{
+			prev->size += it->size;
+			m_runs.erase(it);
+		}
+	}
+}
+
+void FreeSpaceAllocator::clear()
+{
+	m_runs.clear();
+	m_begin = m_end = 0;
+	m_value = 0;
+}
+
+std::size_t FreeSpaceAllocator::freeSize() const noexcept
+{
+	std::size_t total = 0;
+
+	for (const Run_t& run : m_runs)
+		total += run.size;
+
+	return total;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+namespace pepp
+{
+	//! Returned by FreeSpaceAllocator::allocate when no run is large enough
+	static constexpr std::uint32_t NO_FREE_SPACE = 0xffffffff;
+
+	///
+	// - class FreeSpaceAllocator
+	// - Tracks the free (padding) runs of one section's raw data, so code adding data to a section
+	// - (imports, names, thunks..) doesn't have to rescan the section for every allocation.
+	// - Built once from a scan for runs of a filler byte, then updated as space is handed out/returned.
+	// - Offsets are file offsets.
+	///
+	class FreeSpaceAllocator
+	{
+	public:
+		using Run_t = PaddingRun_t;
+
+		FreeSpaceAllocator() = default;
+
+		//! Collect every run of `value` in [data + begin, data + end) that is at least `min_run` bytes long
+		void build(const std::uint8_t* data, std::uint32_t begin, std::uint32_t end, std::uint8_t value, std::size_t min_run = 1);
+
+		//! Lowest offset (aligned to `alignment`, if not 0) with `size` free bytes, or NO_FREE_SPACE.
+		//! The space is no longer free afterwards.
+		std::uint32_t allocate(std::size_t size, std::uint32_t alignment = 0);
+
+		//! Mark [offset, offset + size) as used, e.g data written there by other means
+		void reserve(std::uint32_t offset, std::size_t size);
+
+		//! Return [offset, offset + size) to the free runs, the caller is responsible for the bytes in it
+		void free(std::uint32_t offset, std::size_t size);
+
+		void clear();
+
+		//! Free runs, sorted by offset and never adjacent to each other
+		const std::vector<Run_t>& runs() const noexcept {
+			return m_runs;
+		}
+
+		//! Total free bytes
+		std::size_t freeSize() const noexcept;
+
+		//! Range and filler byte this was built for
+		std::uint32_t begin() const noexcept { return m_begin; }
+		std::uint32_t end() const noexcept { return m_end; }
+		std::uint8_t value() const noexcept { return m_value; }
+
+	private:
+		std::vector<Run_t>	m_runs;
+		std::uint32_t		m_begin = 0;
+		std::uint32_t		m_end = 0;
+		std::uint8_t		m_value = 0;
+	};
+}
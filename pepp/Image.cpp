@@ -4,6 +4,185 @@
 
 using namespace pepp;
 
+namespace
+{
+	// Bytes of a scan range owned by one job, jobs read up to a pattern length past it.
+	constexpr std::size_t scan_chunk_size = 1 << 20;
+
+	struct ScanChunk_t
+	{
+		std::size_t begin;
+		// Matches starting at or past this belong to the next chunk
+		std::size_t own;
+		std::size_t readEnd;
+	};
+
+	//
+	// Split the ranges into chunks overlapping by `overlap` bytes and run `scan` on each.
+	// Every match is reported by exactly one chunk (the one owning its start), so concatenating
+	// the chunk results in order gives the matches sorted by offset with no duplicates.
+	template<typename T, typename ScanFn>
+	std::vector<T> parallelScan(const std::vector<std::pair<std::size_t, std::size_t>>& ranges, std::size_t overlap, msc::ThreadPool* pool, ScanFn&& scan)
+	{
+		std::vector<ScanChunk_t> chunks;
+		std::vector<T> merged;
+
+		for (auto const& [begin, end] : ranges)
+		{
+			for (std::size_t chunk = begin; chunk < end; chunk += scan_chunk_size)
+			{
+				std::size_t own = (std::min)(chunk + scan_chunk_size, end);
+				chunks.push_back({ chunk, own, (std::min)(own + overlap, end) });
+			}
+		}
+
+		if (chunks.empty())
+			return merged;
+
+		if (chunks.size() == 1)
+		{
+			scan(chunks[0], merged);
+			return merged;
+		}
+
+		if (pool == nullptr)
+			pool = &msc::ThreadPool::Shared();
+
+		std::vector<std::vector<T>> results(chunks.size());
+
+		// A job can't wait on its own pool, scan inline then.
+		if (pool->InJob())
+		{
+			for (std::size_t n = 0; n < chunks.size(); n++)
+				scan(chunks[n], results[n]);
+		}
+		else
+		{
+			pool->ParallelFor(chunks.size(), [&](std::size_t n) { scan(chunks[n], results[n]); });
+		}
+
+		std::size_t total = 0;
+		for (auto const& result : results)
+			total += result.size();
+
+		merged.reserve(total);
+		for (auto const& result : results)
+			merged.insert(merged.end(), result.begin(), result.end());
+
+		return merged;
+	}
+
+	//
+	// Feed `str` lowercased (ASCII) to the hash, through a small stack buffer instead of a lowered copy.
+	void hashLower(msc::Md5& md5, std::string_view str)
+	{
+		char chunk[64];
+
+		while (!str.empty())
+		{
+			std::size_t n = (std::min)(str.size(), sizeof(chunk));
+
+			for (std::size_t i = 0; i < n; i++)
+				chunk[i] = (str[i] >= 'A' && str[i] <= 'Z') ? str[i] + ('a' - 'A') : str[i];
+
+			md5.Update(chunk, n);
+			str.remove_prefix(n);
+		}
+	}
+
+	// Fixups applied by one relocation job, blocks are never split. Overridable to tune it with bench/RelocateBench.cpp.
+#ifndef PEPP_RELOCATION_JOB_SIZE
+#define PEPP_RELOCATION_JOB_SIZE (1 << 14)
+#endif
+	constexpr std::size_t relocation_job_size = PEPP_RELOCATION_JOB_SIZE;
+
+	// One validated relocation block (or the run of it that lands in one section): where its page starts in the
+	// file, and its entries. Negative for a run in a section that starts after its page does.
+	struct RelocationBlock_t
+	{
+		std::int64_t			page_offset;
+		const std::uint16_t*	entries;
+		std::uint32_t			count;
+		// File offsets the block patches, [first, last)
+		std::uint64_t			first;
+		std::uint64_t			last;
+	};
+
+	// Width of the value a relocation patches, 0 for types relocateImage doesn't apply.
+	template<unsigned int bitsize>
+	constexpr std::uint32_t fixupSize(RelocationType type) noexcept
+	{
+		switch (type)
+		{
+		case REL_BASED_ABSOLUTE:
+			return 0;
+		case REL_BASED_HIGH:
+		case REL_BASED_LOW:
+			return sizeof(std::uint16_t);
+		case REL_BASED_HIGHLOW:
+			return sizeof(std::uint32_t);
+		case REL_BASED_DIR64:
+			return bitsize == 64 ? sizeof(std::uint64_t) : 0;
+		default:
+			return 0;
+		}
+	}
+
+	template<typename T>
+	void addUnaligned(std::uint8_t* at, T value) noexcept
+	{
+		T current;
+		std::memcpy(&current, at, sizeof current);
+		current += value;
+		std::memcpy(at, &current, sizeof current);
+	}
+
+	// Apply a validated block, no bounds checks.
+	void applyRelocationBlock(std::uint8_t* base, const RelocationBlock_t& block, std::uint64_t delta) noexcept
+	{
+		for (std::uint32_t i = 0; i < block.count; i++)
+		{
+			BlockEntry entry(0, block.entries[i]);
+			std::uint8_t* at = base + (block.page_offset + entry.getOffset());
+
+			switch (entry.getType())
+			{
+			case REL_BASED_DIR64:
+				addUnaligned<std::uint64_t>(at, delta);
+				break;
+			case REL_BASED_HIGHLOW:
+				addUnaligned<std::uint32_t>(at, static_cast<std::uint32_t>(delta));
+				break;
+			case REL_BASED_HIGH:
+				addUnaligned<std::uint16_t>(at, HIWORD(delta));
+				break;
+			case REL_BASED_LOW:
+				addUnaligned<std::uint16_t>(at, LOWORD(delta));
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	// Module name as the imphash uses it: the .dll/.ocx/.sys extension is dropped.
+	std::string_view impHashModule(std::string_view module)
+	{
+		std::size_t dot = module.rfind('.');
+		if (dot == std::string_view::npos)
+			return module;
+
+		std::string_view ext = module.substr(dot + 1);
+		for (std::string_view known : { "dll", "ocx", "sys" })
+		{
+			if (detail::CaseInsensitiveEqual_t{}(ext, known))
+				return module.substr(0, dot);
+		}
+
+		return module;
+	}
+}
+
 // Explicit templates.
 template class Image<32>;
 template class Image<64>;
@@ -18,9 +197,11 @@ template<unsigned int bitsize>
 Image<bitsize>::Image(const Image& rhs)
 	: m_fileName(rhs.m_fileName)
 	//, m_imageBuffer(std::move(rhs.m_imageBuffer)) -- bad
-	, m_imageBuffer(rhs.m_imageBuffer)
 	, m_isParsed(false)
 {
+	// Copy from the view, the source may be file mapped.
+	m_imageBuffer.push_raw(rhs.m_imageView.data(), rhs.m_imageView.size());
+
 	// Ensure that the file was read.
 	assert(m_imageBuffer.size() > 0);
 
@@ -45,10 +226,9 @@ Image<bitsize>::Image(std::string_view filepath)
 {
 	io::File file(m_fileName, io::kFileInput | io::kFileBinary);
 
-	std::vector<uint8_t> data{ file.Read() };
-
-	m_imageBuffer.resize(data.size());
-	m_imageBuffer.copy_data(0, data.data(), data.size());
+	// Read straight into the image buffer.
+	m_imageBuffer.resize(file.GetSize());
+	file.Read(m_imageBuffer.data(), m_imageBuffer.size());
 
 	// Ensure that the file was read.
 	assert(m_imageBuffer.size() > 0);
@@ -71,6 +251,8 @@ Image<bitsize>::Image(const void* data, std::size_t size)
 template<unsigned int bitsize>
 void pepp::Image<bitsize>::setFromMemory(const void* data, std::size_t size)
 {
+	_adoptBuffer();
+
 	m_imageBuffer.resize(size);
 	std::memcpy(&m_imageBuffer[0], data, size);
 
@@ -91,6 +273,8 @@ bool Image<bitsize>::setFromMappedMemory(void* data, std::size_t size) noexcept
 
 	assert(m_PEHeader.isTaggedPE());
 
+	_adoptBuffer();
+
 	m_imageBuffer.resize(size);
 	std::memcpy(&m_imageBuffer[0], data, m_imageBuffer.size());
 
@@ -115,10 +299,18 @@ bool pepp::Image<bitsize>::setFromFilePath(std::string_view file_path)
 	if (!file.Exists())
 		return false;
 
-	std::vector<uint8_t> data{ file.Read() };
+	_adoptBuffer();
 
-	m_imageBuffer.resize(data.size());
-	m_imageBuffer.copy_data(0, data.data(), data.size());
+	// Read straight into the image buffer.
+	m_imageBuffer.resize(file.GetSize());
+	if (!file.Read(m_imageBuffer.data(), m_imageBuffer.size()))
+	{
+		// The view still points at the previous (possibly unmapped) data.
+		m_imageBuffer.clear();
+		m_imageView = mem::ByteView(m_imageBuffer);
+		m_isParsed = false;
+		return false;
+	}
 
 	// Ensure that the file was read.
 	assert(m_imageBuffer.size() > 0);
@@ -130,7 +322,102 @@ bool pepp::Image<bitsize>::setFromFilePath(std::string_view file_path)
 }
 
 template<unsigned int bitsize>
-bool Image<bitsize>::hasDataDirectory(PEDirectoryEntry entry)
+bool pepp::Image<bitsize>::setFromFileMapping(std::string_view file_path, bool copy_on_write)
+{
+	m_fileName = file_path;
+
+	if (!m_mappedFile.Open(m_fileName, copy_on_write))
+	{
+		// A previous mapping is gone now, fall back to the (empty) owned buffer.
+		if (!m_isOwned)
+		{
+			m_isOwned = true;
+			m_imageView = mem::ByteView(m_imageBuffer);
+			m_isParsed = false;
+		}
+		return false;
+	}
+
+	_borrow(m_mappedFile.Data(), m_mappedFile.Size(), copy_on_write);
+
+	return wasParsed();
+}
+
+template<unsigned int bitsize>
+bool Image<bitsize>::getImpHash(msc::Md5::Digest_t& digest) const
+{
+	if (!hasDataDirectory(DIRECTORY_ENTRY_IMPORT))
+		return false;
+
+	msc::Md5 md5;
+	bool first = true;
+
+	for (auto const& imp : getImportDir().imports())
+	{
+		if (!first)
+			md5.Update(",", 1);
+		first = false;
+
+		hashLower(md5, impHashModule(imp.module_name));
+		md5.Update(".", 1);
+
+		if (imp.by_ordinal)
+		{
+			char ordinal[16];
+			int length = snprintf(ordinal, sizeof(ordinal), "ord%u", imp.ordinal);
+			md5.Update(ordinal, length);
+		}
+		else
+		{
+			hashLower(md5, imp.import_name);
+		}
+	}
+
+	if (first)
+		return false;
+
+	digest = md5.Final();
+	return true;
+}
+
+template<unsigned int bitsize>
+std::string Image<bitsize>::getImpHash() const
+{
+	msc::Md5::Digest_t digest;
+	return getImpHash(digest) ? msc::Md5::ToHex(digest) : std::string();
+}
+
+template<unsigned int bitsize>
+bool Image<bitsize>::getExportHash(msc::Md5::Digest_t& digest) const
+{
+	const ExportDirectory<bitsize>& exports = getExportDir();
+
+	if (!exports.isPresent() || exports.getNumberOfNames() == 0)
+		return false;
+
+	msc::Md5 md5;
+
+	for (std::uint32_t i = 0; i < exports.getNumberOfNames(); i++)
+	{
+		if (i != 0)
+			md5.Update(",", 1);
+
+		hashLower(md5, exports.getName(i));
+	}
+
+	digest = md5.Final();
+	return true;
+}
+
+template<unsigned int bitsize>
+std::string Image<bitsize>::getExportHash() const
+{
+	msc::Md5::Digest_t digest;
+	return getExportHash(digest) ? msc::Md5::ToHex(digest) : std::string();
+}
+
+template<unsigned int bitsize>
+bool Image<bitsize>::hasDataDirectory(PEDirectoryEntry entry) const
 {
 	return getPEHdr().getOptionalHdr().getDataDir(entry).Size > 0;
 }
@@ -139,18 +426,67 @@ template<unsigned int bitsize>
 void Image<bitsize>::writeToFile(std::string_view filepath)
 {
 	io::File file(filepath, io::kFileOutput | io::kFileBinary);
-	file.Write(m_imageBuffer);
+	file.Write(base(), size());
+}
+
+template<unsigned int bitsize>
+void Image<bitsize>::_borrow(std::uint8_t* data, std::size_t size, bool writable)
+{
+	// Release any previous owned data, `data` backs the image now.
+	mem::ByteVector().swap(m_imageBuffer);
+
+	m_imageView = mem::ByteView(data, size);
+	m_isOwned = false;
+	m_isWritable = writable;
+	m_isParsed = false;
+
+	// Validate there is a valid MZ signature.
+	_validate();
+}
+
+template<unsigned int bitsize>
+void Image<bitsize>::_adoptBuffer()
+{
+	m_mappedFile.Close();
+	m_isOwned = true;
+	m_isWritable = true;
+}
+
+template<unsigned int bitsize>
+void Image<bitsize>::_detach()
+{
+	m_imageBuffer.resize(m_imageView.size());
+	std::memcpy(m_imageBuffer.data(), m_imageView.data(), m_imageView.size());
+
+	_adoptBuffer();
+
+	// Re-point the headers/directories at the owned copy.
+	_validate();
 }
 
 template<unsigned int bitsize>
 void Image<bitsize>::_validate()
 {
+	// Section layout/contents may have changed.
+	m_freeSpace.clear();
+
+	// The owned buffer may have been resized/reallocated since last time.
+	if (m_isOwned)
+		m_imageView = mem::ByteView(m_imageBuffer);
+
+	if (m_imageView.size() < sizeof(detail::Image_t<>::MZHeader_t))
+		return;
+
 	m_MZHeader = reinterpret_cast<detail::Image_t<>::MZHeader_t*>(base());
 
 	// Valid MZ tag?
 	if (magic() != IMAGE_DOS_SIGNATURE)
 		return;
 
+	// NT headers inside the buffer?
+	if (m_MZHeader->e_lfanew < 0 || m_MZHeader->e_lfanew + sizeof(typename ImageData_t::Header_t) > size())
+		return;
+
 	// Setup the PE header data.
 	m_PEHeader._setup(this);
 
@@ -163,6 +499,13 @@ void Image<bitsize>::_validate()
 	if (m_rawSectionHeaders == nullptr)
 		return;
 
+	// Section table inside the buffer?
+	if ((std::uint8_t*)(m_rawSectionHeaders + getNumberOfSections()) > base() + size())
+		return;
+
+	// Index the sections for address translation.
+	m_PEHeader._indexSections();
+
 	// Ensure the Image class was constructed with the correct bitsize.
 	if constexpr (bitsize == 32)
 	{
@@ -181,6 +524,9 @@ void Image<bitsize>::_validate()
 	// Setup import directory
 	m_importDirectory._setup(this);
 
+	// Setup delay import directory
+	m_delayImportDirectory._setup(this);
+
 	// Setup reloc directory
 	m_relocDirectory._setup(this);
 
@@ -191,8 +537,7 @@ void Image<bitsize>::_validate()
 template<unsigned int bitsize>
 bool Image<bitsize>::appendExport(std::string_view exportName, std::uint32_t rva)
 {
-	getExportDir().add(exportName, rva);
-	return false;
+	return getExportDir().add(exportName, rva);
 }
 
 template<unsigned int bitsize>
@@ -201,14 +546,16 @@ void pepp::Image<bitsize>::scrambleVaData(uint32_t va, uint32_t size)
 	//if (va > GetPEHeader().GetOptionalHeader().GetSizeOfImage())
 	//	return;
 
+	// A read-only mapping is copied to an owned buffer first.
+	mem::ByteVector& data = buffer();
 	uint32_t offset = getPEHdr().rvaToOffset(va);
 
 	for (uint32_t i = 0; i < size; ++i)
 	{
-		if ((offset + i) > buffer().size())
+		if ((offset + i) >= data.size())
 			break;
 
-		buffer().deref<uint8_t>(offset + i) = rand() % 0xff;
+		data[offset + i] = rand() % 0xff;
 	}
 }
 
@@ -231,38 +578,184 @@ bool pepp::Image<bitsize>::isDllOrSystemFile() const
 }
 
 template<unsigned int bitsize>
-void pepp::Image<bitsize>::relocateImage(uintptr_t imageBase)
+bool pepp::Image<bitsize>::relocateImage(uintptr_t imageBase)
 {
-	uintptr_t delta = (imageBase - getImageBase());
+	return _relocateImage(imageBase, nullptr);
+}
+
+template<unsigned int bitsize>
+bool pepp::Image<bitsize>::relocateImage(uintptr_t imageBase, msc::ThreadPool& pool)
+{
+	// A job can't wait on its own pool.
+	return _relocateImage(imageBase, pool.InJob() ? nullptr : &pool);
+}
+
+template<unsigned int bitsize>
+bool pepp::Image<bitsize>::_relocateImage(uintptr_t imageBase, msc::ThreadPool* pool)
+{
+	const std::uint64_t delta = static_cast<std::uint64_t>(imageBase) - static_cast<std::uint64_t>(getImageBase());
+	const SectionIndex::Table& sections = getPEHdr().getSectionIndex().rvaTable();
+	const std::size_t size = view().size();
+	std::vector<RelocationBlock_t> blocks;
+	std::size_t fixups = 0;
+
+	// The stores below go straight to the image data.
+	if (!isWritable())
+		return false;
+
+	//
+	// File offset of `rva`, and how many bytes from there are inside the raw data of its section (the virtual
+	// only tail has no bytes in the file) and the buffer.
+	auto translate = [&](std::uint32_t rva, std::uint32_t& slot, std::int64_t& offset, std::uint64_t& limit)
+	{
+		slot = sections.find(rva);
+		if (slot == SECTION_NOT_FOUND)
+			return false;
+
+		const std::uint32_t rawSize = getSectionHdr(static_cast<std::uint16_t>(sections.section()[slot])).getSizeOfRawData();
+		const std::uint32_t sectionSize = (std::min)(sections.end()[slot] - sections.begin()[slot], rawSize);
+		const std::uint32_t start = rva - sections.begin()[slot];
 
-	m_relocDirectory.forEachEntry(
-		[&](BlockEntry& entry)
+		offset = static_cast<std::int64_t>(sections.target()[slot]) + start;
+		limit = start < sectionSize ? sectionSize - start : 0;
+		limit = (std::min)(limit, static_cast<std::uint64_t>(size) - (std::min)(static_cast<std::uint64_t>(size), static_cast<std::uint64_t>(offset)));
+		return true;
+	};
+
+	//
+	// 1) Validate: every fixup has to land inside its section's raw data and the buffer. A page is translated once
+	// when all of its fixups are in the page's section. Otherwise (a section alignment under 4kb, a page running
+	// into the next section) each fixup is translated on its own, and every run of fixups in one section becomes
+	// a block of its own.
+	bool valid = m_relocDirectory.forEachBlock(
+		[&](const detail::Image_t<>::RelocationBase_t& reloc, const std::uint16_t* entries, std::uint32_t count)
 		{
-			uint32_t offset = getPEHdr().rvaToOffset(entry.getRva());
+			std::uint32_t slot = SECTION_NOT_FOUND;
+			std::int64_t pageOffset = 0;
+			std::uint64_t limit = 0;
+			std::uint32_t first = 0xffffffff, last = 0;
+			bool inPage = translate(reloc.VirtualAddress, slot, pageOffset, limit);
 
-			switch (entry.getType())
+			for (std::uint32_t i = 0; i < count && inPage; i++)
 			{
-			case RelocationType::REL_BASED_ABSOLUTE:
-				break;
-			case RelocationType::REL_BASED_DIR64:
-				if constexpr (bitsize == 32)
-					DebugBreak();
-				buffer().deref<uint64_t>(offset) += delta;
-				break;
-			case RelocationType::REL_BASED_HIGHLOW:
-				buffer().deref<uint32_t>(offset) += (uint32_t)delta;
-				break;
-			case RelocationType::REL_BASED_HIGH:
-				buffer().deref<uint16_t>(offset) += HIWORD(delta);
-				break;
-			case RelocationType::REL_BASED_LOW:
-				buffer().deref<uint16_t>(offset) += LOWORD(delta);
-				break;
-			default:
-				DebugBreak();
+				BlockEntry entry(0, entries[i]);
+				if (entry.getType() == REL_BASED_ABSOLUTE)
+					continue;
+
+				std::uint32_t width = fixupSize<bitsize>(entry.getType());
+				if (width == 0)
+					return false;
+
+				inPage = entry.getOffset() + width <= limit;
+
+				first = (std::min)(first, entry.getOffset());
+				last = (std::max)(last, entry.getOffset() + width);
+			}
+
+			if (inPage)
+			{
+				if (first < last)
+				{
+					blocks.push_back({ pageOffset, entries, count, static_cast<std::uint64_t>(pageOffset + first), static_cast<std::uint64_t>(pageOffset + last) });
+					fixups += count;
+				}
+
+				return true;
+			}
+
+			//
+			// Fixup by fixup, ABSOLUTE padding joins the current run.
+			std::size_t run = blocks.size();
+			slot = SECTION_NOT_FOUND;
+
+			for (std::uint32_t i = 0; i < count; i++)
+			{
+				BlockEntry entry(0, entries[i]);
+				if (entry.getType() == REL_BASED_ABSOLUTE)
+				{
+					if (run != blocks.size())
+						blocks.back().count++;
+					continue;
+				}
+
+				std::uint32_t width = fixupSize<bitsize>(entry.getType());
+				std::uint32_t entrySlot;
+				std::int64_t offset;
+
+				if (width == 0 || !translate(reloc.VirtualAddress + entry.getOffset(), entrySlot, offset, limit) || width > limit)
+					return false;
+
+				if (run == blocks.size() || entrySlot != slot)
+				{
+					blocks.push_back({ offset - entry.getOffset(), entries + i, 0, static_cast<std::uint64_t>(offset), static_cast<std::uint64_t>(offset) });
+					slot = entrySlot;
+				}
+
+				RelocationBlock_t& block = blocks.back();
+				block.count++;
+				block.first = (std::min)(block.first, static_cast<std::uint64_t>(offset));
+				block.last = (std::max)(block.last, static_cast<std::uint64_t>(offset) + width);
+			}
+
+			fixups += count;
+			return true;
+		});
+
+	if (!valid)
+		return false;
+
+	//
+	// 2) Jobs of whole blocks. Blocks run concurrently only if none of them patch the same bytes,
+	// which a well formed table (one block per page) guarantees.
+	std::uint8_t* base = view().data();
+	std::vector<std::size_t> jobs;
+
+	if (pool != nullptr && fixups > relocation_job_size)
+	{
+		std::vector<std::pair<std::uint64_t, std::uint64_t>> ranges;
+		ranges.reserve(blocks.size());
+		for (const RelocationBlock_t& block : blocks)
+			ranges.emplace_back(block.first, block.last);
+
+		std::sort(ranges.begin(), ranges.end());
+
+		bool disjoint = true;
+		for (std::size_t n = 1; n < ranges.size() && disjoint; n++)
+			disjoint = ranges[n - 1].second <= ranges[n].first;
+
+		if (disjoint)
+		{
+			std::size_t size = 0;
+			for (std::size_t n = 0; n < blocks.size(); n++)
+			{
+				if (size == 0)
+					jobs.push_back(n);
+
+				size += blocks[n].count;
+				if (size >= relocation_job_size)
+					size = 0;
 			}
 		}
-	);
+	}
+
+	//
+	// 3) Apply.
+	if (jobs.size() < 2)
+	{
+		for (const RelocationBlock_t& block : blocks)
+			applyRelocationBlock(base, block, delta);
+
+		return true;
+	}
+
+	jobs.push_back(blocks.size());
+
+	pool->ParallelFor(jobs.size() - 1, [&](std::size_t job) {
+		for (std::size_t n = jobs[job]; n < jobs[job + 1]; n++)
+			applyRelocationBlock(base, blocks[n], delta);
+	});
+
+	return true;
 }
 
 template<unsigned int bitsize>
@@ -273,12 +766,14 @@ bool Image<bitsize>::extendSection(std::string_view sectionName, std::uint32_t d
 	if (fileAlignment == 0 || sectAlignment == 0 || delta == 0)
 		return false;
 
+	// Resizing needs an owned buffer.
+	if (!m_isOwned)
+		_detach();
+
 	SectionHeader& header = getSectionHdr(sectionName);
 
 	if (header.getName() != ".dummy")
 	{
-		std::unique_ptr<uint8_t> zero_buf(new uint8_t[delta]{});
-
 		uint32_t ptr = header.getPtrToRawData() + header.getSizeOfRawData();
 
 		header.setSizeOfRawData(align(header.getSizeOfRawData() + delta, fileAlignment));
@@ -299,8 +794,6 @@ bool Image<bitsize>::extendSection(std::string_view sectionName, std::uint32_t d
 		getPEHdr().getOptionalHdr().setSizeOfImage(align(getPEHdr().getOptionalHdr().getSizeOfImage() + delta, sectAlignment));
 
 		// Fill in data
-		//buffer().insert_data(header.getPtrToRawData() + header.getSizeOfRawData(), zero_buf.get(), delta);
-		//buffer().insert_data(header.getPtrToRawData() + header.getSizeOfRawData() - delta, zero_buf.get(), delta);
 		buffer().insert(buffer().begin() + ptr, align(delta, fileAlignment), 0);
 		//buffer().resize(align(buffer().size() + delta, fileAlignment));
 		
@@ -317,115 +810,183 @@ template<unsigned int bitsize>
 std::uint32_t Image<bitsize>::findPadding(SectionHeader* s, std::uint8_t v, std::size_t n, std::uint32_t alignment)
 {
 	bool bTraverseUp = s == nullptr;
-	std::uint32_t startOffset{};
+	std::uint32_t found = -1;
 
 	n = align(n, alignment);
 
 	if (s == nullptr)
 		s = &m_rawSectionHeaders[getNumberOfSections() - 1];
 
-	startOffset = s->getPtrToRawData();
+	const std::uint32_t startOffset = s->getPtrToRawData();
+	const std::uint32_t imageSize = static_cast<std::uint32_t>(size());
 
-	std::vector<uint8_t>::iterator it = buffer().end();
+	if (startOffset >= imageSize)
+		return found;
 
 	// Start from bottom to top, or vice versa?
 	if (bTraverseUp)
 	{
-		std::vector<uint8_t> tmpData(n, v);
+		//
+		// Highest (aligned) fit below the end of the section's raw data.
+		const std::uint32_t endOffset = static_cast<std::uint32_t>((std::min)(static_cast<std::size_t>(startOffset) + s->getSizeOfRawData(), size()));
 
-		for (std::uint32_t i = startOffset + s->getSizeOfRawData(); i > n; i = align(i - n, alignment))
+		for (auto const& run : PaddingRuns(base(), 0, endOffset, v, n))
 		{
-			if (memcmp(&buffer()[i - n], tmpData.data(), tmpData.size()) == 0)
-			{
-				it = buffer().begin() + (i - n);
-				break;
-			}
+			std::uint32_t offset = run.offset + run.size - static_cast<std::uint32_t>(n);
+			if (alignment != 0)
+				offset &= ~(alignment - 1);
+
+			if (offset >= run.offset)
+				found = offset;
 		}
 	}
 	else
 	{
-		std::vector<uint8_t> tmpData(n, v);
-
-		for (std::uint32_t i = startOffset; i < startOffset + (buffer().size() - startOffset); i = align(i + n, alignment))
+		//
+		// Lowest (aligned) fit from the start of the section to the end of the image.
+		for (auto const& run : PaddingRuns(base(), startOffset, imageSize, v, n))
 		{
-			if (memcmp(&buffer()[i], tmpData.data(), tmpData.size()) == 0)
+			std::uint64_t offset = align(static_cast<std::uint64_t>(run.offset), alignment);
+
+			if (offset + n <= static_cast<std::uint64_t>(run.offset) + run.size)
 			{
-				it = buffer().begin() + (i);
+				found = static_cast<std::uint32_t>(offset);
 				break;
 			}
 		}
 	}
 
+	return found;
+}
+
+template<unsigned int bitsize>
+PaddingRuns Image<bitsize>::findPaddingRuns(const SectionHeader* s, std::uint8_t v, std::size_t n) const
+{
+	std::size_t begin, end;
 
-	if (it == buffer().end())
-		return -1;
+	if (!_getSectionBounds(s, begin, end))
+		return PaddingRuns(m_imageView.data(), 0, 0, v, n);
 
-	return (std::uint32_t)std::distance(buffer().begin(), it);
+	return PaddingRuns(m_imageView.data(), static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(end), v, n);
 }
 
 template<unsigned int bitsize>
-std::uint32_t Image<bitsize>::findZeroPadding(SectionHeader* s, std::size_t n, std::uint32_t alignment)
+PaddingRuns Image<bitsize>::findPaddingRuns(std::uint8_t v, std::size_t n) const
 {
-	return findPadding(s, 0x0, n, alignment);
+	return PaddingRuns(m_imageView.data(), 0, static_cast<std::uint32_t>(size()), v, n);
 }
 
 template<unsigned int bitsize>
-std::vector<std::uint32_t> Image<bitsize>::findBinarySequence(SectionHeader* s, std::string_view binary_seq) const
+std::uint32_t Image<bitsize>::allocateInSection(std::string_view section_name, std::uint32_t size, std::uint32_t alignment)
 {
-	constexpr auto ascii_to_byte = [](const char ch) [[msvc::forceinline]] {
-				if (ch >= '0' && ch <= '9')
-					return std::uint8_t(ch - '0');
-				if (ch >= 'A' && ch <= 'F')
-					return std::uint8_t(ch - 'A' + '\n');
-				return std::uint8_t(ch - 'a' + '\n');
-	};
+	//
+	// Reuse padding of sections we added before, as long as it is mapped as well.
+	for (std::uint16_t i = 0; i < getNumberOfSections(); i++)
+	{
+		SectionHeader& sec = getSectionHdr(i);
+		if (sec.getName() != section_name)
+			continue;
 
-	std::vector<std::uint32_t> offsets{};
+		FreeSpaceAllocator& freeSpace = getFreeSpace(sec, 0xcc);
+		std::uint32_t offset = freeSpace.allocate(size, alignment);
+		if (offset == NO_FREE_SPACE)
+			continue;
+
+		if (offset + size <= sec.getPtrToRawData() + (std::min)(sec.getSizeOfRawData(), sec.getVirtualSize()))
+			return offset;
+
+		freeSpace.free(offset, size);
+	}
+
+	//
+	// Virtual size == raw size, so the padding left behind is usable by the next build.
+	SectionHeader sec;
+	std::uint32_t sectionSize = align(size, getPEHdr().getOptionalHdr().getFileAlignment());
+
+	if (!appendSection(section_name, sectionSize, SCN_MEM_READ | SCN_MEM_WRITE | SCN_CNT_INITIALIZED_DATA, &sec))
+		return NO_FREE_SPACE;
+
+	std::memset(buffer().template as<void*>(sec.getPtrToRawData()), 0xcc, sec.getSizeOfRawData());
+
+	return getFreeSpace(getSectionHdr(getNumberOfSections() - 1), 0xcc).allocate(size, alignment);
+}
+
+template<unsigned int bitsize>
+void Image<bitsize>::releaseInSection(std::string_view section_name, std::uint32_t offset, std::uint32_t size)
+{
+	if (offset == 0 || size == 0)
+		return;
+
+	SectionHeader& sec = getSectionHdrFromOffset(offset);
+
+	if (sec.getName() != section_name)
+		return;
+
+	std::memset(&buffer()[offset], 0xcc, size);
+	getFreeSpace(sec, 0xcc).free(offset, size);
+}
+
+template<unsigned int bitsize>
+FreeSpaceAllocator& Image<bitsize>::getFreeSpace(const SectionHeader& s, std::uint8_t v)
+{
+	std::size_t begin, end;
+
+	if (!_getSectionBounds(&s, begin, end))
+		end = begin;
 
+	for (auto& freeSpace : m_freeSpace)
+	{
+		if (freeSpace->begin() == begin && freeSpace->end() == end && freeSpace->value() == v)
+			return *freeSpace;
+	}
+
+	auto& freeSpace = m_freeSpace.emplace_back(std::make_unique<FreeSpaceAllocator>());
+	freeSpace->build(view().data(), static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(end), v);
+
+	return *freeSpace;
+}
+
+template<unsigned int bitsize>
+std::uint32_t Image<bitsize>::findZeroPadding(SectionHeader* s, std::size_t n, std::uint32_t alignment)
+{
+	return findPadding(s, 0x0, n, alignment);
+}
+
+template<unsigned int bitsize>
+bool Image<bitsize>::_getSectionBounds(const SectionHeader* s, std::size_t& begin, std::size_t& end) const noexcept
+{
 	if (s == nullptr)
 		s = &m_rawSectionHeaders[getNumberOfSections() - 1];
 
-	std::uint32_t start_offset = s->getPtrToRawData();
-	std::uint32_t result = 0;
-	std::uint32_t match_count = 0;
+	// Clamp the raw data to the buffer, headers can't be trusted.
+	begin = s->getPtrToRawData();
+	end = (std::min)(begin + s->getSizeOfRawData(), size());
 
-	for (std::uint32_t i = start_offset; i <= start_offset + s->getSizeOfRawData(); ++i)
-	{
-		for (int c = 0; c < binary_seq.size();)
-		{
-			if (binary_seq[c] == ' ')
-			{
-				++c;
-				continue;
-			}
+	return begin < end;
+}
 
-			if (binary_seq[c] == '?')
-			{
-				++c;
-				++match_count;
-				continue;
-			}
+template<unsigned int bitsize>
+std::vector<std::uint32_t> Image<bitsize>::findBinarySequence(SectionHeader* s, std::string_view binary_seq) const
+{
+	return findBinarySequence(s, CompiledPattern(binary_seq));
+}
 
-			if (buffer()[i + match_count++] != ((ascii_to_byte(binary_seq[c]) << 4) | ascii_to_byte(binary_seq[c + 1])))
-			{
-				result = 0;
-				break;
-			}
+template<unsigned int bitsize>
+std::vector<std::uint32_t> Image<bitsize>::findBinarySequence(SectionHeader* s, const CompiledPattern& pattern) const
+{
+	std::vector<std::uint32_t> offsets{};
+	std::size_t begin, end;
 
-			result = i;
-			c += 2;
-		}
-	
-		if (result)
-		{
-			offsets.emplace_back(i);
-			i += match_count - 1;
-		}
+	if (!_getSectionBounds(s, begin, end))
+		return offsets;
 
-		
-		match_count = 0;
-		result = 0;
-	}
+	const std::uint8_t* data = m_imageView.data() + begin;
+	const std::size_t length = end - begin;
+
+	//
+	// Matches don't overlap, scanning resumes after the end of each match.
+	for (std::size_t i = pattern.find(data, length); i != CompiledPattern::npos; i = pattern.find(data, length, i + pattern.size()))
+		offsets.emplace_back(static_cast<std::uint32_t>(begin + i));
 
 	return offsets;
 }
@@ -433,71 +994,170 @@ std::vector<std::uint32_t> Image<bitsize>::findBinarySequence(SectionHeader* s,
 template<unsigned int bitsize>
 std::vector<std::pair<std::int32_t, std::uint32_t>> Image<bitsize>::findBinarySequences(SectionHeader* s, std::initializer_list<std::pair<std::int32_t, std::string_view>> binary_seq) const
 {
-	constexpr auto ascii_to_byte = [](const char ch) [[msvc::forceinline]] {
-				if (ch >= '0' && ch <= '9')
-					return std::uint8_t(ch - '0');
-				if (ch >= 'A' && ch <= 'F')
-					return std::uint8_t(ch - 'A' + '\n');
-				return std::uint8_t(ch - 'a' + '\n');
-	};
+	PatternSet patterns;
+
+	// Parse every pattern once up front, malformed ones are skipped.
+	for (auto const& seq : binary_seq)
+		patterns.add(seq.first, seq.second);
+
+	return findBinarySequences(s, patterns);
+}
+
+template<unsigned int bitsize>
+std::vector<std::pair<std::int32_t, std::uint32_t>> Image<bitsize>::findBinarySequences(SectionHeader* s, std::span<const std::pair<std::int32_t, CompiledPattern>> patterns) const
+{
+	PatternSet set;
+
+	for (auto const& [id, pattern] : patterns)
+		set.add(id, pattern);
+
+	return findBinarySequences(s, set);
+}
 
+template<unsigned int bitsize>
+std::vector<std::pair<std::int32_t, std::uint32_t>> Image<bitsize>::findBinarySequences(SectionHeader* s, const PatternSet& patterns) const
+{
 	std::vector<std::pair<std::int32_t, std::uint32_t>> offsets{};
+	std::size_t begin, end;
 
-	if (s == nullptr)
-		s = &m_rawSectionHeaders[getNumberOfSections() - 1];
+	if (!_getSectionBounds(s, begin, end))
+		return offsets;
+
+	patterns.scan(m_imageView.data() + begin, end - begin, offsets, static_cast<std::uint32_t>(begin));
+	return offsets;
+}
+
+template<unsigned int bitsize>
+std::vector<std::pair<std::size_t, std::size_t>> Image<bitsize>::_getScanRanges(ScanScope scope) const
+{
+	std::vector<const SectionHeader*> sections;
 
-	std::uint32_t start_offset = s->getPtrToRawData();
-	std::pair<std::int32_t, std::uint32_t> result{};
-	std::uint32_t match_count = 0;
+	if (scope == ScanScope::WholeImage)
+		return { { 0, size() } };
 
-	for (std::uint32_t i = start_offset; i <= start_offset + s->getSizeOfRawData(); ++i)
+	for (std::uint16_t i = 0; i < getNumberOfSections(); i++)
 	{
-		for (auto const& seq : binary_seq)
-		{
-			for (int c = 0; c < seq.second.size();)
-			{
-				if (seq.second[c] == ' ')
-				{
-					++c;
-					continue;
-				}
+		if (m_rawSectionHeaders[i].isExecutable())
+			sections.push_back(&m_rawSectionHeaders[i]);
+	}
 
-				if (seq.second[c] == '?')
-				{
-					++c;
-					++match_count;
-					continue;
-				}
+	if (sections.empty())
+		return {};
 
-				std::uint8_t _byte = ((ascii_to_byte(seq.second[c]) << 4) | ascii_to_byte(seq.second[c + 1]));
+	return _getScanRanges(sections);
+}
 
-				if (buffer()[i + match_count++] != _byte)
-				{
-					result = { 0,0 };
-					break;
-				}
+template<unsigned int bitsize>
+std::vector<std::pair<std::size_t, std::size_t>> Image<bitsize>::_getScanRanges(std::span<const SectionHeader* const> sections) const
+{
+	std::vector<std::pair<std::size_t, std::size_t>> ranges;
+	std::size_t begin, end;
 
-				result = {seq.first, i};
-				c += 2;
-			}
+	for (const SectionHeader* s : sections)
+	{
+		if (_getSectionBounds(s, begin, end))
+			ranges.emplace_back(begin, end);
+	}
 
-			if (result.second)
-			{
-				offsets.emplace_back(std::move(result));
-				break;
-			}
+	//
+	// Merge overlapping/adjacent ranges, so no byte gets scanned twice.
+	std::sort(ranges.begin(), ranges.end());
 
-			match_count = 0;
-			result = { 0, 0 };
-		}
+	std::size_t count = 0;
+	for (auto const& range : ranges)
+	{
+		if (count != 0 && range.first <= ranges[count - 1].second)
+			ranges[count - 1].second = (std::max)(ranges[count - 1].second, range.second);
+		else
+			ranges[count++] = range;
+	}
+
+	ranges.resize(count);
+	return ranges;
+}
 
-		i += std::max<int>(match_count - 1, 0);
-		match_count = 0;
+template<unsigned int bitsize>
+std::vector<std::uint32_t> Image<bitsize>::findBinarySequence(ScanScope scope, const CompiledPattern& pattern, msc::ThreadPool* pool) const
+{
+	return _findBinarySequence(_getScanRanges(scope), pattern, pool);
+}
+
+template<unsigned int bitsize>
+std::vector<std::uint32_t> Image<bitsize>::findBinarySequence(std::span<const SectionHeader* const> sections, const CompiledPattern& pattern, msc::ThreadPool* pool) const
+{
+	return _findBinarySequence(_getScanRanges(sections), pattern, pool);
+}
+
+template<unsigned int bitsize>
+std::vector<std::pair<std::int32_t, std::uint32_t>> Image<bitsize>::findBinarySequences(ScanScope scope, const PatternSet& patterns, msc::ThreadPool* pool) const
+{
+	return _findBinarySequences(_getScanRanges(scope), patterns, pool);
+}
+
+template<unsigned int bitsize>
+std::vector<std::pair<std::int32_t, std::uint32_t>> Image<bitsize>::findBinarySequences(std::span<const SectionHeader* const> sections, const PatternSet& patterns, msc::ThreadPool* pool) const
+{
+	return _findBinarySequences(_getScanRanges(sections), patterns, pool);
+}
+
+template<unsigned int bitsize>
+std::vector<std::uint32_t> Image<bitsize>::_findBinarySequence(const std::vector<std::pair<std::size_t, std::size_t>>& ranges, const CompiledPattern& pattern, msc::ThreadPool* pool) const
+{
+	std::vector<std::uint32_t> offsets{};
+
+	if (!pattern.valid())
+		return offsets;
+
+	const std::uint8_t* base = m_imageView.data();
+
+	//
+	// Chunks report every match they own, overlapping ones included.
+	std::vector<std::uint32_t> matches = parallelScan<std::uint32_t>(ranges, pattern.size() - 1, pool,
+		[&](const ScanChunk_t& chunk, std::vector<std::uint32_t>& out) {
+			const std::uint8_t* data = base + chunk.begin;
+			const std::size_t length = chunk.readEnd - chunk.begin;
+			const std::size_t own = chunk.own - chunk.begin;
+
+			for (std::size_t i = pattern.find(data, length); i != CompiledPattern::npos && i < own; i = pattern.find(data, length, i + 1))
+				out.push_back(static_cast<std::uint32_t>(chunk.begin + i));
+		});
+
+	//
+	// Then drop the overlapping ones, which leaves exactly what a sequential scan
+	// resuming after each match finds.
+	std::size_t next = 0;
+	for (std::uint32_t offset : matches)
+	{
+		if (offset < next)
+			continue;
+
+		offsets.push_back(offset);
+		next = offset + pattern.size();
 	}
 
 	return offsets;
 }
 
+template<unsigned int bitsize>
+std::vector<std::pair<std::int32_t, std::uint32_t>> Image<bitsize>::_findBinarySequences(const std::vector<std::pair<std::size_t, std::size_t>>& ranges, const PatternSet& patterns, msc::ThreadPool* pool) const
+{
+	using Match_t = std::pair<std::int32_t, std::uint32_t>;
+
+	if (patterns.empty())
+		return {};
+
+	const std::uint8_t* base = m_imageView.data();
+
+	return parallelScan<Match_t>(ranges, patterns.maxPatternSize() - 1, pool,
+		[&](const ScanChunk_t& chunk, std::vector<Match_t>& out) {
+			patterns.scan(base + chunk.begin, chunk.readEnd - chunk.begin, out, static_cast<std::uint32_t>(chunk.begin));
+
+			// Matches in the overlap are reported by the next chunk.
+			out.erase(std::partition_point(out.begin(), out.end(),
+				[&chunk](const Match_t& match) { return match.second < chunk.own; }), out.end());
+		});
+}
+
 template<unsigned int bitsize>
 bool Image<bitsize>::appendSection(std::string_view section_name, std::uint32_t size, std::uint32_t chrs, SectionHeader* out)
 {
@@ -506,6 +1166,10 @@ bool Image<bitsize>::appendSection(std::string_view section_name, std::uint32_t
 	if (fileAlignment == 0 || sectAlignment == 0)
 		return false;
 
+	// Resizing needs an owned buffer.
+	if (!m_isOwned)
+		_detach();
+
 	std::uint32_t alignedFileSize = align(size, fileAlignment);
 	std::uint32_t alignedVirtSize = size;
 	std::uint32_t oldFileSize = getPEHdr().getOptionalHdr().getSizeOfImage();
@@ -551,6 +1215,10 @@ bool Image<bitsize>::appendSection(std::string_view section_name, std::uint32_t
 template<unsigned int bitsize>
 void pepp::Image<bitsize>::setAsMapped() noexcept
 {
+	// The section headers are part of the image data.
+	if (!isWritable())
+		return;
+
 	for (std::uint16_t i = 0; i < getNumberOfSections(); ++i)
 	{
 		SectionHeader& sec = getSectionHdr(i);
@@ -559,6 +1227,9 @@ void pepp::Image<bitsize>::setAsMapped() noexcept
 		sec.setSizeOfRawData(sec.getVirtualSize());
 	}
 
+	// Raw data pointers moved, so re-index.
+	m_PEHeader._indexSections();
+
 	m_isMemMapped = true;
 }
 
@@ -5,12 +5,19 @@ namespace pepp
 	template<unsigned int>
 	class PEHeader;
 	class SectionHeader;
+	class CompiledPattern;
+	class PatternSet;
+	class FreeSpaceAllocator;
 	template<unsigned int>
 	class ExportDirectory;
 	template<unsigned int>
 	class ImportDirectory;
 	template<unsigned int>
+	class DelayImportDirectory;
+	template<unsigned int>
 	class RelocationDirectory;
+	template<unsigned int>
+	class ImageView;
 	enum SectionCharacteristics;
 	enum PEDirectoryEntry;
 	enum class PEMachine;
@@ -23,6 +30,7 @@ namespace pepp
 			using MZHeader_t = IMAGE_DOS_HEADER;
 			using ImportDescriptor_t = IMAGE_IMPORT_DESCRIPTOR;
 			using BoundImportDescriptor_t = IMAGE_BOUND_IMPORT_DESCRIPTOR;
+			using DelayImportDescriptor_t = IMAGE_DELAYLOAD_DESCRIPTOR;
 			using ResourceDirectory_t = IMAGE_RESOURCE_DIRECTORY;
 			using ResourceDirectoryEntry_t = IMAGE_RESOURCE_DIRECTORY_ENTRY;
 			using SectionHeader_t = IMAGE_SECTION_HEADER;
@@ -52,6 +60,15 @@ namespace pepp
 		};
 	}
 
+	// - Parts of an image covered by a parallel scan
+	enum class ScanScope
+	{
+		// - Every byte of the file, headers and overlay included
+		WholeImage,
+		// - Raw data of every section marked SCN_MEM_EXECUTE
+		ExecutableSections
+	};
+
 	/// 
 	// - class Image
 	// - Used for runtime or static analysis/manipulating of PE files.
@@ -69,12 +86,21 @@ namespace pepp
 		using ImageData_t = detail::Image_t<bitsize>;
 
 		friend class PEHeader<bitsize>;
+		friend class ImageView<bitsize>;
 
 		static_assert(bitsize == 32 || bitsize == 64, "Invalid bitsize fed into PE::Image");
 	private:	
 		detail::Image_t<>::MZHeader_t*			m_MZHeader;
 		std::string								m_fileName{};
 		mem::ByteVector							m_imageBuffer{};
+		// - Bytes the image is parsed from (m_imageBuffer, or a file mapping)
+		mem::ByteView							m_imageView{};
+		// - Backing mapping when loaded via setFromFileMapping
+		io::MappedFile							m_mappedFile{};
+		// - Does m_imageView point into m_imageBuffer?
+		bool									m_isOwned = true;
+		// - May m_imageView be written to? (false for read-only mappings and views)
+		bool									m_isWritable = true;
 		PEHeader<bitsize>						m_PEHeader;
 		// - Sections
 		SectionHeader*							m_rawSectionHeaders;
@@ -82,8 +108,12 @@ namespace pepp
 		ExportDirectory<bitsize>				m_exportDirectory;
 		// - Imports
 		ImportDirectory<bitsize>				m_importDirectory;
+		// - Delay load imports
+		DelayImportDirectory<bitsize>			m_delayImportDirectory;
 		// - Relocations
 		RelocationDirectory<bitsize>			m_relocDirectory;
+		// - Free space of sections, built on demand by getFreeSpace and dropped on every _validate
+		std::vector<std::unique_ptr<FreeSpaceAllocator>>	m_freeSpace;
 		// - Is image mapped? Rva2Offset becomes obsolete
 		bool									m_isMemMapped = false;
 		// - Is image successfully parsed?
@@ -107,17 +137,52 @@ namespace pepp
 		bool setFromMappedMemory(void* data, std::size_t size) noexcept;
 		bool setFromFilePath(std::string_view file_path);
 
+		// - Map the file instead of reading it; pages are only loaded once touched.
+		// - A copy-on-write mapping allows in-place edits (e.g relocateImage) without touching the file,
+		// - a read-only mapping must not be written to.
+		bool setFromFileMapping(std::string_view file_path, bool copy_on_write = true);
+
 		// - Get the start pointer of the buffer.
 		std::uint8_t* base() {
-			return m_imageBuffer.data();
+			return m_imageView.data();
+		}
+
+		// - Size of the image data in bytes.
+		std::size_t size() const {
+			return m_imageView.size();
 		}
 
+		// - Owning buffer, needed for edits that resize the image.
+		// - A file mapped image is copied into an owned buffer (once) on first use.
 		mem::ByteVector& buffer() {
+			if (!m_isOwned)
+				_detach();
 			return m_imageBuffer;
 		}
 
-		const mem::ByteVector& buffer() const {
-			return m_imageBuffer;
+		// - Read-only access never detaches (which would re-validate the image and invalidate the views
+		// - it handed out), so this is the image data as it is, mapped or owned.
+		const mem::ByteView& buffer() const {
+			return m_imageView;
+		}
+
+		// - Non-owning view of the image data, valid for every load mode.
+		mem::ByteView& view() {
+			return m_imageView;
+		}
+
+		const mem::ByteView& view() const {
+			return m_imageView;
+		}
+
+		// - Is the image backed by a file mapping?
+		bool isFileMapped() const {
+			return m_mappedFile.IsOpen();
+		}
+
+		// - Can the image data be edited in place? (buffer() always can, it copies a read-only mapping first)
+		bool isWritable() const {
+			return m_isWritable;
 		}
 
 		// - Magic number in the DOS header.
@@ -143,6 +208,10 @@ namespace pepp
 			return m_importDirectory;
 		}
 
+		class DelayImportDirectory<bitsize>& getDelayImportDir() {
+			return m_delayImportDirectory;
+		}
+
 		class RelocationDirectory<bitsize>& getRelocDir() {
 			return m_relocDirectory;
 		}
@@ -159,6 +228,10 @@ namespace pepp
 			return m_importDirectory;
 		}
 
+		const class DelayImportDirectory<bitsize>& getDelayImportDir() const {
+			return m_delayImportDirectory;
+		}
+
 		const class RelocationDirectory<bitsize>& getRelocDir() const {
 			return m_relocDirectory;
 		}
@@ -169,6 +242,7 @@ namespace pepp
 		}
 
 		// - Assign all sections to the appropriate VA
+		// - Does nothing on a read-only mapping, call buffer() first to work on an owned copy.
 		void setAsMapped() noexcept;
 
 		void mapToBuffer(pepp::Address<> base, const std::vector<std::string>& ignore = {});
@@ -194,8 +268,15 @@ namespace pepp
 		bool isSystemFile() const;
 		bool isDllOrSystemFile() const;
 
-		// - 
-		void relocateImage(uintptr_t imageBase);
+		// - Apply the base relocations for a move to `imageBase` (the header's ImageBase is left as is).
+		// - Every block is checked first (in bounds, known types), nothing is written if one isn't valid.
+		// - Fails on images that aren't writable (read-only mappings).
+		bool relocateImage(uintptr_t imageBase);
+
+		// - Same, with the blocks split across `pool`. Blocks cover disjoint pages, images where the patched
+		// - ranges of two blocks overlap are relocated on the calling thread. So is everything when called from
+		// - a job of `pool` itself (e.g relocating many images in a ParallelFor over the same pool).
+		bool relocateImage(uintptr_t imageBase, msc::ThreadPool& pool);
 
 		// - Find offset padding of value v with count n, starting at specified header or bottom of image if none specified
 		std::uint32_t findPadding(SectionHeader* s, std::uint8_t v, std::size_t n, std::uint32_t alignment = 0);
@@ -203,14 +284,56 @@ namespace pepp
 		// - Find offset zero padding up to N bytes, starting at specified header or bottom of image if none specified
 		std::uint32_t findZeroPadding(SectionHeader* s, std::size_t n, std::uint32_t alignment = 0);
 
-		// - Find (wildcard acceptable) binary sequence
+		// - Every run of `v` at least `n` bytes long, as (offset, size), in a section's raw data (last section if null)
+		// - or the whole image. Runs are found while iterating, so a best fit can be picked in one pass.
+		PaddingRuns findPaddingRuns(const SectionHeader* s, std::uint8_t v, std::size_t n) const;
+		PaddingRuns findPaddingRuns(std::uint8_t v, std::size_t n) const;
+
+		// - Free runs of `v` in a section's raw data, scanned on first use and reused after that.
+		// - Re-validating the image (appending/extending sections, detaching a mapping) drops them, don't keep the reference around.
+		FreeSpaceAllocator& getFreeSpace(const SectionHeader& s, std::uint8_t v = 0xcc);
+
+		// - File offset of `size` bytes taken from the 0xcc free space of a section named `section_name` (mapped part only),
+		// - a section of that name is appended if none has room. Used by the directory builders, NO_FREE_SPACE on failure.
+		std::uint32_t allocateInSection(std::string_view section_name, std::uint32_t size, std::uint32_t alignment);
+
+		// - Give [offset, offset + size) back to the free space if it lies in a section named `section_name`
+		void releaseInSection(std::string_view section_name, std::uint32_t offset, std::uint32_t size);
+
+		// - Find (wildcard acceptable) binary sequence, starting at specified header or bottom of image if none specified
 		std::vector<std::uint32_t> findBinarySequence(SectionHeader* s, std::string_view binary_seq) const;
 		std::vector<std::pair<std::int32_t, std::uint32_t>> findBinarySequences(SectionHeader* s, std::initializer_list<std::pair<std::int32_t, std::string_view>> binary_seq) const;
 
+		// - Same as above, with patterns that were compiled ahead of time (and can be reused across images)
+		std::vector<std::uint32_t> findBinarySequence(SectionHeader* s, const CompiledPattern& pattern) const;
+		std::vector<std::pair<std::int32_t, std::uint32_t>> findBinarySequences(SectionHeader* s, std::span<const std::pair<std::int32_t, CompiledPattern>> patterns) const;
+
+		// - Match a whole signature set in a single pass, every (id, offset) match is returned in offset order
+		std::vector<std::pair<std::int32_t, std::uint32_t>> findBinarySequences(SectionHeader* s, const PatternSet& patterns) const;
+
+		// - Scan a scope or a list of sections, split in chunks that run on `pool` (the shared pool if null)
+		// - Results are in offset order without duplicates, same as scanning each range in one go
+		// - Called from a job of that pool the chunks run inline on the calling thread
+		std::vector<std::uint32_t> findBinarySequence(ScanScope scope, const CompiledPattern& pattern, msc::ThreadPool* pool = nullptr) const;
+		std::vector<std::uint32_t> findBinarySequence(std::span<const SectionHeader* const> sections, const CompiledPattern& pattern, msc::ThreadPool* pool = nullptr) const;
+		std::vector<std::pair<std::int32_t, std::uint32_t>> findBinarySequences(ScanScope scope, const PatternSet& patterns, msc::ThreadPool* pool = nullptr) const;
+		std::vector<std::pair<std::int32_t, std::uint32_t>> findBinarySequences(std::span<const SectionHeader* const> sections, const PatternSet& patterns, msc::ThreadPool* pool = nullptr) const;
+
+		// - Import hash (pefile's imphash): MD5 over "module.import" for every import, lowercase, module without
+		// - its .dll/.ocx/.sys extension, "ordN" for imports by ordinal, joined by ','. Streamed from the import table.
+		// - False (empty string) if the image has no imports.
+		bool getImpHash(msc::Md5::Digest_t& digest) const;
+		std::string getImpHash() const;
+
+		// - MD5 over the export names in name table order, lowercase and joined by ','.
+		// - False (empty string) if the image has no named exports.
+		bool getExportHash(msc::Md5::Digest_t& digest) const;
+		std::string getExportHash() const;
+
 		// - Check if a data directory is "present"
 		// - - Necessary before actually using the directory
 		// -  (e.g not all images will have a valid IMAGE_EXPORT_DIRECTORY)
-		bool hasDataDirectory(PEDirectoryEntry entry);
+		bool hasDataDirectory(PEDirectoryEntry entry) const;
 
 		// - Write out to file
 		void writeToFile(std::string_view filepath);
@@ -243,6 +366,29 @@ namespace pepp
 	private:
 		// - Setup internal objects/pointers and validate they are proper.
 		void _validate();
+
+		// - Raw data range of a section (last section if null), clamped to the buffer.
+		bool _getSectionBounds(const SectionHeader* s, std::size_t& begin, std::size_t& end) const noexcept;
+
+		// - File offset ranges covered by a scan, sorted and merged.
+		std::vector<std::pair<std::size_t, std::size_t>> _getScanRanges(ScanScope scope) const;
+		std::vector<std::pair<std::size_t, std::size_t>> _getScanRanges(std::span<const SectionHeader* const> sections) const;
+
+		// - Parallel scans over merged ranges.
+		std::vector<std::uint32_t> _findBinarySequence(const std::vector<std::pair<std::size_t, std::size_t>>& ranges, const CompiledPattern& pattern, msc::ThreadPool* pool) const;
+		std::vector<std::pair<std::int32_t, std::uint32_t>> _findBinarySequences(const std::vector<std::pair<std::size_t, std::size_t>>& ranges, const PatternSet& patterns, msc::ThreadPool* pool) const;
+
+		// - relocateImage, serial if `pool` is null.
+		bool _relocateImage(uintptr_t imageBase, msc::ThreadPool* pool);
+
+		// - Parse directly over memory the image doesn't own.
+		void _borrow(std::uint8_t* data, std::size_t size, bool writable);
+
+		// - Drop any mapping so that m_imageBuffer backs the image again.
+		void _adoptBuffer();
+
+		// - Copy mapped data into m_imageBuffer and re-validate.
+		void _detach();
 	};
 
 	using Image64 = Image<64>;
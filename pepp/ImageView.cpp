@@ -0,0 +1,25 @@
+#include "PELibrary.hpp"
+
+using namespace pepp;
+
+// Explicit templates.
+template class ImageView<32>;
+template class ImageView<64>;
+
+template<unsigned int bitsize>
+ImageView<bitsize>::ImageView(std::span<const std::uint8_t> data)
+{
+	setFromSpan(data);
+}
+
+template<unsigned int bitsize>
+bool ImageView<bitsize>::setFromSpan(std::span<const std::uint8_t> data)
+{
+	// Any previous file mapping isn't needed anymore.
+	m_image._adoptBuffer();
+
+	// The view never writes, the buffer is only borrowed.
+	m_image._borrow(const_cast<std::uint8_t*>(data.data()), data.size(), false);
+
+	return m_image.wasParsed();
+}
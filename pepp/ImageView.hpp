@@ -0,0 +1,120 @@
+#pragma once
+
+#include <span>
+
+namespace pepp
+{
+	/// 
+	// - class ImageView
+	// - Read-only parsing of a caller owned buffer (network captures, memory dumps, archive members..)
+	// - Nothing is copied or allocated, so the buffer must outlive the view and stay unmodified while in use.
+	/// 
+	template<unsigned int bitsize = 32>
+	class ImageView : pepp::msc::NonCopyable
+	{
+		Image<bitsize>							m_image;
+	public:
+
+		// - Publicize the detail::Image_t used by this image.
+		using ImageData_t = detail::Image_t<bitsize>;
+
+		// - Default ctor.
+		ImageView() = default;
+
+		// - Used to construct a `class ImageView` over a caller owned buffer
+		ImageView(std::span<const std::uint8_t> data);
+
+		// - Initialization routine
+		bool setFromSpan(std::span<const std::uint8_t> data);
+
+		// - Get the start pointer of the buffer.
+		const std::uint8_t* base() const {
+			return m_image.view().data();
+		}
+
+		// - Size of the viewed buffer.
+		std::size_t size() const {
+			return m_image.size();
+		}
+
+		std::span<const std::uint8_t> data() const {
+			return { base(), size() };
+		}
+
+		const mem::ByteView& view() const {
+			return m_image.view();
+		}
+
+		// - Magic number in the DOS header.
+		std::uint16_t magic() const {
+			return m_image.magic();
+		}
+
+		// - Get the Image Base
+		detail::Image_t<bitsize>::Address_t getImageBase() const noexcept {
+			return m_image.getImageBase();
+		}
+
+		const PEHeader<bitsize>& getPEHdr() const {
+			return m_image.getPEHdr();
+		}
+
+		const class ExportDirectory<bitsize>& getExportDir() const {
+			return m_image.getExportDir();
+		}
+
+		const class ImportDirectory<bitsize>& getImportDir() const {
+			return m_image.getImportDir();
+		}
+
+		const class DelayImportDirectory<bitsize>& getDelayImportDir() const {
+			return m_image.getDelayImportDir();
+		}
+
+		const class RelocationDirectory<bitsize>& getRelocDir() const {
+			return m_image.getRelocDir();
+		}
+
+		// - Wrappers
+		const SectionHeader& getSectionHdr(std::uint16_t dwIndex) const {
+			return m_image.getPEHdr().getSectionHeader(dwIndex);
+		}
+		const SectionHeader& getSectionHdr(std::string_view name) const {
+			return m_image.getPEHdr().getSectionHeader(name);
+		}
+		const SectionHeader& getSectionHdrFromVa(std::uint32_t va) const {
+			return m_image.getPEHdr().getSectionHeaderFromVa(va);
+		}
+		const SectionHeader& getSectionHdrFromOffset(std::uint32_t offset) const {
+			return m_image.getPEHdr().getSectionHeaderFromOffset(offset);
+		}
+		std::uint16_t getNumberOfSections() const {
+			return m_image.getNumberOfSections();
+		}
+
+		bool hasDataDirectory(PEDirectoryEntry entry) const {
+			return m_image.hasDataDirectory(entry);
+		}
+
+		bool isDll() const {
+			return m_image.isDll();
+		}
+
+		bool isSystemFile() const {
+			return m_image.isSystemFile();
+		}
+
+		bool isDllOrSystemFile() const {
+			return m_image.isDllOrSystemFile();
+		}
+
+		static constexpr unsigned int getBitSize() { return bitsize; }
+
+		bool wasParsed() const {
+			return m_image.wasParsed();
+		}
+	};
+
+	using ImageView64 = ImageView<64>;
+	using ImageView86 = ImageView<32>;
+}
@@ -0,0 +1,277 @@
+#include "PELibrary.hpp"
+
+using namespace pepp;
+
+// Explicit templates.
+template class ImportBuilder<32>;
+template class ImportBuilder<64>;
+
+template<unsigned int bitsize>
+ImportBuilder<bitsize>::ImportBuilder(Image<bitsize>& image)
+	: m_image(&image)
+{
+}
+
+template<unsigned int bitsize>
+std::size_t ImportBuilder<bitsize>::add(std::string_view module, std::string_view import)
+{
+	m_entries.push_back({ std::string(module), std::string(import), 0, false, 0, 0 });
+	return m_entries.size() - 1;
+}
+
+template<unsigned int bitsize>
+std::size_t ImportBuilder<bitsize>::add(std::string_view module, std::uint16_t ordinal)
+{
+	m_entries.push_back({ std::string(module), std::string(), ordinal, true, 0, 0 });
+	return m_entries.size() - 1;
+}
+
+template<unsigned int bitsize>
+void ImportBuilder<bitsize>::setTargetImage(std::string_view module, const Image<bitsize>& dll, bool by_ordinal)
+{
+	for (Target_t& target : m_targets)
+	{
+		if (detail::CaseInsensitiveEqual_t{}(target.module, module))
+		{
+			target.dll = &dll;
+			target.by_ordinal = by_ordinal;
+			return;
+		}
+	}
+
+	m_targets.push_back({ std::string(module), &dll, by_ordinal });
+}
+
+template<unsigned int bitsize>
+bool ImportBuilder<bitsize>::build(std::string_view section_name)
+{
+	using Descriptor_t = detail::Image_t<>::ImportDescriptor_t;
+	using Address_t = typename detail::Image_t<bitsize>::Address_t;
+
+	struct Group_t
+	{
+		std::string_view			module;
+		//! Existing module name, 0 if the name has to be written
+		std::uint32_t				name_rva;
+		//! Distinct imports, as indices of the first entry asking for each
+		std::vector<std::size_t>	slots;
+		std::uint32_t				int_offset;
+		std::uint32_t				iat_offset;
+		std::uint32_t				name_offset;
+	};
+
+	// Resizing needs an owned buffer, take it before any offsets are computed.
+	m_image->buffer();
+
+	const std::uint32_t word = static_cast<std::uint32_t>(m_image->getWordSize());
+	ImportDirectory<bitsize>& imports = m_image->getImportDir();
+	IMAGE_DATA_DIRECTORY& dir = m_image->getPEHdr().getOptionalHdr().getDataDir(DIRECTORY_ENTRY_IMPORT);
+	const bool hasImports = m_image->hasDataDirectory(DIRECTORY_ENTRY_IMPORT);
+
+	std::vector<Group_t> groups;
+	// (group, slot) of every pending entry
+	std::vector<std::pair<std::size_t, std::size_t>> placement(m_entries.size(), { SIZE_MAX, 0 });
+
+	//
+	// 1) Skip what the image already imports, group the rest by module.
+	for (std::size_t n = 0; n < m_entries.size(); n++)
+	{
+		Entry_t& entry = m_entries[n];
+
+		if (entry.iat_rva != 0)
+			continue;
+
+		//
+		// Resolve names against the target DLL: the hint is the index of the name in its
+		// (sorted) export name table, the ordinal follows from it.
+		if (!entry.by_ordinal)
+		{
+			auto target = std::find_if(m_targets.begin(), m_targets.end(),
+				[&entry](const Target_t& t) { return detail::CaseInsensitiveEqual_t{}(t.module, entry.module); });
+
+			if (target != m_targets.end())
+			{
+				const ExportDirectory<bitsize>& exports = target->dll->getExportDir();
+				std::uint32_t idx = exports.findNameIndex(entry.name);
+
+				if (idx != EXPORT_NOT_FOUND)
+				{
+					entry.hint = static_cast<std::uint16_t>(idx);
+
+					if (target->by_ordinal)
+					{
+						entry.ordinal = static_cast<std::uint16_t>(exports.getBase() + exports.getNameOrdinal(idx));
+						entry.by_ordinal = true;
+					}
+				}
+			}
+		}
+
+		if (hasImports)
+		{
+			bool found = entry.by_ordinal
+				? imports.hasModuleImport(entry.module, entry.ordinal, &entry.iat_rva)
+				: imports.hasModuleImport(entry.module, entry.name, &entry.iat_rva);
+			if (found)
+				continue;
+		}
+
+		auto group = std::find_if(groups.begin(), groups.end(),
+			[&entry](const Group_t& g) { return detail::CaseInsensitiveEqual_t{}(g.module, entry.module); });
+
+		if (group == groups.end())
+		{
+			std::uint32_t nameRva = 0;
+			if (hasImports)
+				imports.importsModule(entry.module, &nameRva);
+
+			group = groups.insert(groups.end(), Group_t{ entry.module, nameRva });
+		}
+
+		// The same import queued twice shares one slot.
+		std::size_t slot = 0;
+		for (; slot < group->slots.size(); slot++)
+		{
+			const Entry_t& other = m_entries[group->slots[slot]];
+			if (other.by_ordinal == entry.by_ordinal && (entry.by_ordinal ? other.ordinal == entry.ordinal : other.name == entry.name))
+				break;
+		}
+
+		if (slot == group->slots.size())
+			group->slots.push_back(n);
+
+		placement[n] = { static_cast<std::size_t>(group - groups.begin()), slot };
+	}
+
+	if (groups.empty())
+		return true;
+
+	//
+	// 2) Existing descriptors are kept as they are.
+	std::vector<Descriptor_t> descriptors;
+
+	if (hasImports)
+	{
+		const Descriptor_t* descriptor = m_image->view().template as<const Descriptor_t*>(m_image->getPEHdr().rvaToOffset(dir.VirtualAddress));
+
+		for (; descriptor->FirstThunk != 0; descriptor++)
+			descriptors.push_back(*descriptor);
+	}
+
+	//
+	// 3) Layout: descriptors, then INT/IAT pairs, hint/name entries and module names.
+	const std::uint32_t tableSize = static_cast<std::uint32_t>((descriptors.size() + groups.size() + 1) * sizeof(Descriptor_t));
+	std::uint32_t size = align(tableSize, word);
+	std::vector<std::uint32_t> nameOffsets(m_entries.size(), 0);
+
+	for (Group_t& group : groups)
+	{
+		const std::uint32_t thunks = static_cast<std::uint32_t>((group.slots.size() + 1) * word);
+
+		group.int_offset = size;
+		group.iat_offset = size + thunks;
+		size += 2 * thunks;
+	}
+
+	for (Group_t& group : groups)
+	{
+		for (std::size_t n : group.slots)
+		{
+			if (m_entries[n].by_ordinal)
+				continue;
+
+			nameOffsets[n] = size;
+			size += align(static_cast<std::uint32_t>(sizeof(std::uint16_t) + m_entries[n].name.size() + 1), 2u);
+		}
+	}
+
+	for (Group_t& group : groups)
+	{
+		if (group.name_rva != 0)
+			continue;
+
+		group.name_offset = size;
+		size += static_cast<std::uint32_t>(group.module.size() + 1);
+	}
+
+	//
+	// 4) Place and write the block.
+	const std::uint32_t oldTableRva = hasImports ? dir.VirtualAddress : 0;
+	const std::uint32_t offset = m_image->allocateInSection(section_name, size, word);
+
+	if (offset == NO_FREE_SPACE)
+		return false;
+
+	const std::uint32_t rva = m_image->getPEHdr().offsetToRva(offset);
+	std::uint8_t* block = &m_image->buffer()[offset];
+
+	std::memset(block, 0, size);
+	std::memcpy(block, descriptors.data(), descriptors.size() * sizeof(Descriptor_t));
+
+	Descriptor_t* descriptor = reinterpret_cast<Descriptor_t*>(block) + descriptors.size();
+
+	for (Group_t& group : groups)
+	{
+		Address_t* intThunk = reinterpret_cast<Address_t*>(block + group.int_offset);
+		Address_t* iatThunk = reinterpret_cast<Address_t*>(block + group.iat_offset);
+
+		if (group.name_rva == 0)
+		{
+			std::memcpy(block + group.name_offset, group.module.data(), group.module.size());
+			group.name_rva = rva + group.name_offset;
+		}
+
+		descriptor->OriginalFirstThunk = rva + group.int_offset;
+		descriptor->FirstThunk = rva + group.iat_offset;
+		descriptor->Name = group.name_rva;
+		descriptor++;
+
+		for (std::size_t slot = 0; slot < group.slots.size(); slot++)
+		{
+			const Entry_t& entry = m_entries[group.slots[slot]];
+			Address_t thunk;
+
+			if (entry.by_ordinal)
+			{
+				if constexpr (bitsize == 64)
+					thunk = IMPORT_ORDINAL_FLAG_64 | entry.ordinal;
+				else
+					thunk = IMPORT_ORDINAL_FLAG_32 | entry.ordinal;
+			}
+			else
+			{
+				std::uint8_t* hintName = block + nameOffsets[group.slots[slot]];
+
+				std::memcpy(hintName, &entry.hint, sizeof(std::uint16_t));
+				std::memcpy(hintName + sizeof(std::uint16_t), entry.name.data(), entry.name.size());
+				thunk = rva + nameOffsets[group.slots[slot]];
+			}
+
+			// Unbound: the IAT starts out as a copy of the INT.
+			intThunk[slot] = thunk;
+			iatThunk[slot] = thunk;
+		}
+	}
+
+	for (std::size_t n = 0; n < m_entries.size(); n++)
+	{
+		if (placement[n].first == SIZE_MAX)
+			continue;
+
+		m_entries[n].iat_rva = rva + groups[placement[n].first].iat_offset + static_cast<std::uint32_t>(placement[n].second * word);
+	}
+
+	//
+	// 5) Point the directory at the new table. A previous table we placed ourselves goes back to the free space.
+	IMAGE_DATA_DIRECTORY& newDir = m_image->getPEHdr().getOptionalHdr().getDataDir(DIRECTORY_ENTRY_IMPORT);
+	const std::uint32_t oldTableOffset = oldTableRva ? m_image->getPEHdr().rvaToOffset(oldTableRva) : 0;
+	const std::uint32_t oldTableSize = static_cast<std::uint32_t>((descriptors.size() + 1) * sizeof(Descriptor_t));
+
+	newDir.VirtualAddress = rva;
+	newDir.Size = tableSize;
+
+	m_image->releaseInSection(section_name, oldTableOffset, oldTableSize);
+
+	imports._setup(m_image);
+	return true;
+}
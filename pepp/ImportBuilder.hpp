@@ -0,0 +1,70 @@
+#pragma once
+
+namespace pepp
+{
+	///
+	// - class ImportBuilder
+	// - Collects imports to add to an image and writes a complete new import directory in one pass:
+	// - descriptors (existing ones are kept as they are, their IATs don't move), INT, IAT,
+	// - hint/name entries and module names, sized exactly and placed as one block.
+	// - The block goes into free space of a section named `section_name` if one has room,
+	// - otherwise a new section of that name is appended.
+	///
+	template<unsigned int bitsize>
+	class ImportBuilder : pepp::msc::NonCopyable
+	{
+		struct Entry_t
+		{
+			std::string		module;
+			std::string		name;
+			std::uint16_t	ordinal;
+			bool			by_ordinal;
+			//! Hint written in the hint/name entry
+			std::uint16_t	hint;
+			//! 0 until build() placed (or found) the import
+			std::uint32_t	iat_rva;
+		};
+
+		struct Target_t
+		{
+			std::string				module;
+			const Image<bitsize>*	dll;
+			bool					by_ordinal;
+		};
+
+		Image<bitsize>*			m_image;
+		std::vector<Entry_t>	m_entries;
+		std::vector<Target_t>	m_targets;
+	public:
+		explicit ImportBuilder(Image<bitsize>& image);
+
+		//! Queue an import by name, returns a handle for getIatRva()
+		std::size_t add(std::string_view module, std::string_view import);
+
+		//! Queue an import by ordinal, returns a handle for getIatRva()
+		std::size_t add(std::string_view module, std::uint16_t ordinal);
+
+		//! `module` resolves to `dll`: names imported from it get the hint of their export name entry,
+		//! or are imported by ordinal instead if `by_ordinal` is set. `dll` must outlive build().
+		void setTargetImage(std::string_view module, const Image<bitsize>& dll, bool by_ordinal = false);
+
+		//! Write the new import directory. Imports the image already has are not added again,
+		//! their existing IAT slot is returned instead. Can be called again after adding more.
+		bool build(std::string_view section_name = ".pepp");
+
+		//! IAT rva of a queued import once build() succeeded, 0 before
+		std::uint32_t getIatRva(std::size_t handle) const {
+			return handle < m_entries.size() ? m_entries[handle].iat_rva : 0;
+		}
+
+		//! Number of queued imports
+		std::size_t size() const noexcept {
+			return m_entries.size();
+		}
+
+		void clear() {
+			m_entries.clear();
+			m_targets.clear();
+		}
+	};
+}
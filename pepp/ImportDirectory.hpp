@@ -16,26 +16,30 @@ namespace pepp
 		bool										ordinal;
 	};
 
-	static constexpr auto IMPORT_ORDINAL_FLAG_32 = IMAGE_ORDINAL_FLAG32;
-	static constexpr auto IMPORT_ORDINAL_FLAG_64 = IMAGE_ORDINAL_FLAG64;
+	template<unsigned int bitsize>
+	class ImportBuilder;
 
 	template<unsigned int bitsize>
-	class ImportDirectory : pepp::msc::NonCopyable
+	class ImportDirectory : public ImportTable<bitsize, detail::Image_t<>::ImportDescriptor_t>
 	{
 		friend class Image<32>;
 		friend class Image<64>;
+		friend class ImportBuilder<bitsize>;
+
+		using Table_t = ImportTable<bitsize, detail::Image_t<>::ImportDescriptor_t>;
+		using Table_t::m_image;
+		using Table_t::m_base;
+		using Table_t::_resetIndex;
 
-		Image<bitsize>*							m_image;
-		detail::Image_t<>::ImportDescriptor_t*	m_base;
-		detail::Image_t<>::ImportAddressTable_t m_iat_base;
+		detail::Image_t<>::ImportAddressTable_t m_iat_base = 0;
 	public:
 		ImportDirectory() = default;
 
-		bool importsModule(std::string_view module, std::uint32_t* name_rva = nullptr) const;
-		bool hasModuleImport(std::string_view module, std::string_view import, std::uint32_t* rva = nullptr) const;
+		//! Single ImportBuilder passes, use ImportBuilder directly to add many modules at once.
+		//! `rva` receives the IAT rva of every import (0 if the directory couldn't be written).
 		void addModuleImport(std::string_view module, std::string_view import, std::uint32_t* rva = nullptr);
 		void addModuleImports(std::string_view module, std::initializer_list<std::string_view> imports, std::uint32_t* rva = nullptr);
-		void traverseImports(const std::function<void(ModuleImportData_t*)>& cb_func);
+		void traverseImports(const std::function<void(ModuleImportData_t*)>& cb_func) const;
 
 		void setCharacteristics(std::uint32_t chrs) {
 			m_base->Characteristics = chrs;
@@ -53,21 +57,23 @@ namespace pepp
 			return m_base->TimeDateStamp;
 		}
 
-		//! Util
-		template<typename T>
-		bool isImportOrdinal(T ord) const requires pepp::msc::MemoryAddress<T> {
-			if constexpr (bitsize == 64)
-				return (ord & IMPORT_ORDINAL_FLAG_64) != 0;
-			return (ord & IMPORT_ORDINAL_FLAG_32) != 0;
-		}
+		using Table_t::isImportOrdinal;
 
-		void getIATOffsets(std::uint32_t& begin, std::uint32_t& end) noexcept;
-		void getIATRvas(std::uint32_t& begin, std::uint32_t& end) noexcept;
+		void getIATOffsets(std::uint32_t& begin, std::uint32_t& end) const noexcept;
+		void getIATRvas(std::uint32_t& begin, std::uint32_t& end) const noexcept;
 
 	private:
 		//! Setup the directory
 		void _setup(Image<bitsize>* image) {
+			_resetIndex();
 			m_image = image;
+			m_base = nullptr;
+			m_iat_base = 0;
+
+			// Without a table the offsets below would point at the DOS header.
+			if (!image->hasDataDirectory(DIRECTORY_ENTRY_IMPORT))
+				return;
+
 			m_base = reinterpret_cast<decltype(m_base)>(
 				&image->base()[image->getPEHdr().rvaToOffset(
 					image->getPEHdr().getOptionalHdr().getDataDir(DIRECTORY_ENTRY_IMPORT).VirtualAddress)]);		
@@ -0,0 +1,200 @@
+#include "PELibrary.hpp"
+
+using namespace pepp;
+
+// Explicit templates.
+template class ImportTable<32, detail::Image_t<>::ImportDescriptor_t>;
+template class ImportTable<64, detail::Image_t<>::ImportDescriptor_t>;
+template class ImportTable<32, detail::Image_t<>::DelayImportDescriptor_t>;
+template class ImportTable<64, detail::Image_t<>::DelayImportDescriptor_t>;
+
+template<unsigned int bitsize, typename Descriptor>
+void ImportTable<bitsize, Descriptor>::_buildIndex() const
+{
+	if (m_indexBuilt.load(std::memory_order_acquire))
+		return;
+
+	std::lock_guard<std::mutex> lock(m_indexLock);
+
+	if (m_indexBuilt.load(std::memory_order_relaxed))
+		return;
+
+	//
+	// The iterator already does the descriptor/thunk walk (and VA translation), index what it yields.
+	for (auto const& imp : imports())
+	{
+		auto [it, inserted] = m_index.try_emplace(imp.module_name);
+		IndexedModule_t& module = it->second;
+
+		if (inserted)
+			module.name_rva = imp.module_name_rva;
+
+		// The first descriptor importing a symbol wins, like a walk over the descriptors would.
+		if (imp.by_ordinal)
+			module.ordinals.try_emplace(imp.ordinal, imp.import_rva);
+		else
+			module.names.try_emplace(imp.import_name, imp.import_rva);
+	}
+
+	m_indexBuilt.store(true, std::memory_order_release);
+}
+
+template<unsigned int bitsize, typename Descriptor>
+bool ImportTable<bitsize, Descriptor>::importsModule(std::string_view module, std::uint32_t* name_rva) const
+{
+	_buildIndex();
+
+	auto it = m_index.find(module);
+
+	if (name_rva)
+		*name_rva = it != m_index.end() ? it->second.name_rva : 0;
+
+	return it != m_index.end();
+}
+
+template<unsigned int bitsize, typename Descriptor>
+bool ImportTable<bitsize, Descriptor>::hasModuleImport(std::string_view module, std::string_view import, std::uint32_t* rva) const
+{
+	_buildIndex();
+
+	if (rva)
+		*rva = 0;
+
+	auto it = m_index.find(module);
+	if (it == m_index.end())
+		return false;
+
+	auto imp = it->second.names.find(import);
+	if (imp == it->second.names.end())
+		return false;
+
+	if (rva)
+		*rva = imp->second;
+
+	return true;
+}
+
+template<unsigned int bitsize, typename Descriptor>
+bool ImportTable<bitsize, Descriptor>::hasModuleImport(std::string_view module, std::uint16_t ordinal, std::uint32_t* rva) const
+{
+	_buildIndex();
+
+	if (rva)
+		*rva = 0;
+
+	auto it = m_index.find(module);
+	if (it == m_index.end())
+		return false;
+
+	auto imp = it->second.ordinals.find(ordinal);
+	if (imp == it->second.ordinals.end())
+		return false;
+
+	if (rva)
+		*rva = imp->second;
+
+	return true;
+}
+
+template<unsigned int bitsize, typename Descriptor>
+ImportTable<bitsize, Descriptor>::ImportIterator::ImportIterator(const ImportTable* table)
+	: m_table(table)
+{
+	// A rejected image never set the table up.
+	if (table->m_image == nullptr || table->m_base == nullptr)
+		return;
+
+	m_cursor = SectionIndex::Cursor(table->m_image->getPEHdr().getSectionIndex().rvaTable());
+	m_descriptor = table->m_base;
+	_enterDescriptor();
+}
+
+template<unsigned int bitsize, typename Descriptor>
+typename ImportTable<bitsize, Descriptor>::ImportIterator& ImportTable<bitsize, Descriptor>::ImportIterator::operator++()
+{
+	mem::ByteView const& buffer = m_table->m_image->view();
+
+	m_thunk++;
+	m_index++;
+
+	// A thunk table cut off by the end of the image ends like a terminated one.
+	if (reinterpret_cast<const std::uint8_t*>(m_thunk + 1) <= buffer.data() + buffer.size() && m_thunk->u1.AddressOfData)
+	{
+		_load();
+		return *this;
+	}
+
+	m_descriptor++;
+	_enterDescriptor();
+	return *this;
+}
+
+template<unsigned int bitsize, typename Descriptor>
+std::string_view ImportTable<bitsize, Descriptor>::ImportIterator::_stringAt(std::uint32_t offset) const
+{
+	mem::ByteView const& buffer = m_table->m_image->view();
+
+	if (offset == 0 || offset >= buffer.size())
+		return {};
+
+	const char* str = reinterpret_cast<const char*>(buffer.data() + offset);
+	return std::string_view(str, strnlen(str, buffer.size() - offset));
+}
+
+template<unsigned int bitsize, typename Descriptor>
+void ImportTable<bitsize, Descriptor>::ImportIterator::_enterDescriptor()
+{
+	mem::ByteView const& buffer = m_table->m_image->view();
+	const std::uint64_t imageBase = m_table->m_image->getImageBase();
+
+	//
+	// The table ends with a zeroed descriptor, skip descriptors without imports (or with a bad name table).
+	for (; reinterpret_cast<const std::uint8_t*>(m_descriptor + 1) <= buffer.data() + buffer.size() && !Traits_t::isEnd(*m_descriptor); m_descriptor++)
+	{
+		std::uint32_t thunkOffset = _toOffset(Traits_t::lookupRva(*m_descriptor, imageBase));
+		if (thunkOffset == 0 || thunkOffset + sizeof(Thunk_t) > buffer.size())
+			continue;
+
+		m_thunk = buffer.as<const Thunk_t*>(thunkOffset);
+		m_index = 0;
+
+		if (m_thunk->u1.AddressOfData)
+		{
+			m_entry.module_name_rva = Traits_t::nameRva(*m_descriptor, imageBase);
+			m_entry.module_name = _stringAt(_toOffset(m_entry.module_name_rva));
+			_load();
+			return;
+		}
+	}
+
+	// End.
+	m_descriptor = nullptr;
+	m_thunk = nullptr;
+}
+
+template<unsigned int bitsize, typename Descriptor>
+void ImportTable<bitsize, Descriptor>::ImportIterator::_load()
+{
+	const std::uint64_t imageBase = m_table->m_image->getImageBase();
+
+	m_entry.import_rva = Traits_t::iatRva(*m_descriptor, imageBase) + (m_index * m_table->m_image->getWordSize());
+	m_entry.by_ordinal = m_table->isImportOrdinal(m_thunk->u1.Ordinal);
+
+	if (m_entry.by_ordinal)
+	{
+		m_entry.ordinal = static_cast<std::uint16_t>(m_thunk->u1.Ordinal & 0xffff);
+		m_entry.import_name = {};
+		m_entry.import_name_rva = 0;
+		m_entry.hint = 0;
+		return;
+	}
+
+	std::uint32_t hintNameRva = Traits_t::toRva(*m_descriptor, m_thunk->u1.AddressOfData, imageBase);
+	std::uint32_t offset = _toOffset(hintNameRva);
+	mem::ByteView const& buffer = m_table->m_image->view();
+
+	m_entry.ordinal = 0;
+	m_entry.import_name_rva = hintNameRva + sizeof(std::uint16_t);
+	m_entry.hint = offset != 0 && offset + sizeof(std::uint16_t) <= buffer.size() ? buffer.deref<std::uint16_t>(offset) : 0;
+	m_entry.import_name = offset != 0 ? _stringAt(offset + sizeof(std::uint16_t)) : std::string_view{};
+}
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <string_view>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+
+namespace pepp
+{
+	//! One import yielded by ImportDirectory::imports(), names point into the image buffer
+	struct ImportEntry_t
+	{
+		std::string_view							module_name;
+		std::uint32_t								module_name_rva;
+		//! Empty for imports by ordinal
+		std::string_view							import_name;
+		//! 0 for imports by ordinal
+		std::uint32_t								import_name_rva;
+		std::uint16_t								hint;
+		//! Only set for imports by ordinal
+		std::uint16_t								ordinal;
+		//! IAT slot of the import
+		std::uint32_t								import_rva;
+		bool										by_ordinal;
+	};
+
+	static constexpr auto IMPORT_ORDINAL_FLAG_32 = IMAGE_ORDINAL_FLAG32;
+	static constexpr auto IMPORT_ORDINAL_FLAG_64 = IMAGE_ORDINAL_FLAG64;
+
+	namespace detail
+	{
+		//! ASCII case-insensitive hash/compare, module names are case-insensitive on Windows
+		struct CaseInsensitiveHash_t
+		{
+			std::size_t operator()(std::string_view str) const noexcept {
+				std::size_t hash = 0xcbf29ce484222325ull;
+				for (char c : str)
+				{
+					hash ^= static_cast<std::uint8_t>((c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c);
+					hash *= 0x100000001b3ull;
+				}
+				return hash;
+			}
+		};
+
+		struct CaseInsensitiveEqual_t
+		{
+			bool operator()(std::string_view lhs, std::string_view rhs) const noexcept {
+				if (lhs.size() != rhs.size())
+					return false;
+				for (std::size_t i = 0; i < lhs.size(); i++)
+				{
+					char l = (lhs[i] >= 'A' && lhs[i] <= 'Z') ? lhs[i] + ('a' - 'A') : lhs[i];
+					char r = (rhs[i] >= 'A' && rhs[i] <= 'Z') ? rhs[i] + ('a' - 'A') : rhs[i];
+					if (l != r)
+						return false;
+				}
+				return true;
+			}
+		};
+
+		//! Where a descriptor keeps its module name and thunk tables, as rvas
+		template<typename Descriptor>
+		struct ImportDescriptorTraits_t;
+
+		template<>
+		struct ImportDescriptorTraits_t<Image_t<>::ImportDescriptor_t>
+		{
+			using Descriptor_t = Image_t<>::ImportDescriptor_t;
+
+			static bool isEnd(const Descriptor_t& descriptor) noexcept {
+				return descriptor.FirstThunk == 0;
+			}
+			static std::uint32_t toRva(const Descriptor_t&, std::uint64_t value, std::uint64_t) noexcept {
+				return static_cast<std::uint32_t>(value);
+			}
+			static std::uint32_t nameRva(const Descriptor_t& descriptor, std::uint64_t) noexcept {
+				return descriptor.Name;
+			}
+			//! Descriptors may lack an OriginalFirstThunk, the (unbound) IAT holds the same data then
+			static std::uint32_t lookupRva(const Descriptor_t& descriptor, std::uint64_t) noexcept {
+				return descriptor.OriginalFirstThunk ? descriptor.OriginalFirstThunk : descriptor.FirstThunk;
+			}
+			static std::uint32_t iatRva(const Descriptor_t& descriptor, std::uint64_t) noexcept {
+				return descriptor.FirstThunk;
+			}
+		};
+
+		template<>
+		struct ImportDescriptorTraits_t<Image_t<>::DelayImportDescriptor_t>
+		{
+			using Descriptor_t = Image_t<>::DelayImportDescriptor_t;
+
+			static bool isEnd(const Descriptor_t& descriptor) noexcept {
+				return descriptor.DllNameRVA == 0;
+			}
+			//! Descriptors without the rva based attribute (old linkers) hold VAs
+			static std::uint32_t toRva(const Descriptor_t& descriptor, std::uint64_t value, std::uint64_t image_base) noexcept {
+				if (value == 0 || (descriptor.Attributes.AllAttributes & 1) != 0)
+					return static_cast<std::uint32_t>(value);
+				return static_cast<std::uint32_t>(value - image_base);
+			}
+			static std::uint32_t nameRva(const Descriptor_t& descriptor, std::uint64_t image_base) noexcept {
+				return toRva(descriptor, descriptor.DllNameRVA, image_base);
+			}
+			static std::uint32_t lookupRva(const Descriptor_t& descriptor, std::uint64_t image_base) noexcept {
+				return toRva(descriptor, descriptor.ImportNameTableRVA, image_base);
+			}
+			static std::uint32_t iatRva(const Descriptor_t& descriptor, std::uint64_t image_base) noexcept {
+				return toRva(descriptor, descriptor.ImportAddressTableRVA, image_base);
+			}
+		};
+	}
+
+	///
+	// - class ImportTable
+	// - What ImportDirectory and DelayImportDirectory share: walking a zero terminated descriptor table
+	// - (ImportIterator) and the case-insensitive module -> imports index behind the lookups.
+	// - `Descriptor` picks the layout through detail::ImportDescriptorTraits_t.
+	///
+	template<unsigned int bitsize, typename Descriptor>
+	class ImportTable : pepp::msc::NonCopyable
+	{
+	protected:
+		using Descriptor_t = Descriptor;
+		using Traits_t = detail::ImportDescriptorTraits_t<Descriptor>;
+
+		//! Imports of one module (all descriptors naming it), names point into the image buffer
+		struct IndexedModule_t
+		{
+			std::uint32_t									name_rva;
+			std::unordered_map<std::string_view, std::uint32_t>	names;
+			std::unordered_map<std::uint16_t, std::uint32_t>	ordinals;
+		};
+
+		Image<bitsize>*							m_image = nullptr;
+		//! nullptr if there is no table
+		Descriptor_t*							m_base = nullptr;
+		//! Module -> imports (import -> IAT rva), built on the first lookup and dropped whenever imports change
+		mutable std::unordered_map<std::string_view, IndexedModule_t, detail::CaseInsensitiveHash_t, detail::CaseInsensitiveEqual_t> m_index;
+		mutable std::atomic<bool>				m_indexBuilt{ false };
+		mutable std::mutex						m_indexLock;
+	public:
+		///
+		// - Forward iterator over every import of every descriptor, without allocating.
+		// - Invalidated by anything that changes the imports or the image buffer.
+		///
+		class ImportIterator
+		{
+			using Thunk_t = typename detail::Image_t<bitsize>::ThunkData_t;
+
+			const ImportTable*			m_table = nullptr;
+			SectionIndex::Cursor		m_cursor;
+			//! nullptr once past the last descriptor
+			const Descriptor_t*			m_descriptor = nullptr;
+			const Thunk_t*				m_thunk = nullptr;
+			std::uint32_t				m_index = 0;
+			ImportEntry_t				m_entry{};
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = ImportEntry_t;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const ImportEntry_t*;
+			using reference = const ImportEntry_t&;
+
+			ImportIterator() = default;
+			//! The end iterator if the table isn't set up (or has no descriptors)
+			explicit ImportIterator(const ImportTable* table);
+
+			reference operator*() const { return m_entry; }
+			pointer operator->() const { return &m_entry; }
+
+			ImportIterator& operator++();
+			ImportIterator operator++(int) {
+				ImportIterator it = *this;
+				++*this;
+				return it;
+			}
+
+			bool operator==(const ImportIterator& rhs) const {
+				return m_descriptor == rhs.m_descriptor && m_thunk == rhs.m_thunk;
+			}
+			bool operator!=(const ImportIterator& rhs) const {
+				return !(*this == rhs);
+			}
+
+		private:
+			//! Translate through the cursor, 0 on a miss (like PEHeader::rvaToOffset)
+			std::uint32_t _toOffset(std::uint32_t rva) {
+				std::uint32_t offset = m_cursor.translate(rva);
+				return offset != SECTION_NOT_FOUND ? offset : 0;
+			}
+
+			//! Null terminated string at `offset`, cut at the end of the buffer
+			std::string_view _stringAt(std::uint32_t offset) const;
+
+			//! Move to the first import of the current (or a later) descriptor
+			void _enterDescriptor();
+
+			//! Fill m_entry from m_thunk
+			void _load();
+		};
+
+		class ImportRange
+		{
+			const ImportTable* m_table;
+		public:
+			explicit ImportRange(const ImportTable* table) : m_table(table) {}
+
+			ImportIterator begin() const { return ImportIterator(m_table); }
+			ImportIterator end() const { return ImportIterator(); }
+		};
+
+		//! Every import, e.g `for (auto const& imp : image.getImportDir().imports())`. Empty if there is no table.
+		ImportRange imports() const {
+			return ImportRange(this);
+		}
+
+		bool importsModule(std::string_view module, std::uint32_t* name_rva = nullptr) const;
+		bool hasModuleImport(std::string_view module, std::string_view import, std::uint32_t* rva = nullptr) const;
+		bool hasModuleImport(std::string_view module, std::uint16_t ordinal, std::uint32_t* rva = nullptr) const;
+
+		//! Util
+		template<typename T>
+		bool isImportOrdinal(T ord) const requires pepp::msc::MemoryAddress<T> {
+			if constexpr (bitsize == 64)
+				return (ord & IMPORT_ORDINAL_FLAG_64) != 0;
+			return (ord & IMPORT_ORDINAL_FLAG_32) != 0;
+		}
+
+	protected:
+		ImportTable() = default;
+
+		//! Build m_index if it isn't already, safe to call from several threads
+		void _buildIndex() const;
+
+		//! Drop m_index, it is rebuilt by the next lookup
+		void _resetIndex() {
+			std::lock_guard<std::mutex> lock(m_indexLock);
+			m_index.clear();
+			m_indexBuilt.store(false, std::memory_order_release);
+		}
+	};
+}
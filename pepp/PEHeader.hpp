@@ -23,6 +23,7 @@ namespace pepp
 		ImageData_t::Header_t*			m_PEHdr = nullptr;
 		FileHeader						m_FileHeader;
 		OptionalHeader<bitsize>			m_OptionalHeader;
+		SectionIndex					m_sectionIndex;
 	private:
 		//! Private constructor, this should never be established outside of `class Image`
 		PEHeader();
@@ -53,6 +54,10 @@ namespace pepp
 			return dummy;
 		}
 
+		const SectionHeader& getSectionHeader(std::uint16_t dwIndex) const {
+			return const_cast<PEHeader*>(this)->getSectionHeader(dwIndex);
+		}
+
 		SectionHeader& getSectionHeader(std::string_view name) {
 			static SectionHeader dummy{};
 
@@ -66,63 +71,75 @@ namespace pepp
 			return dummy;
 		}
 
+		const SectionHeader& getSectionHeader(std::string_view name) const {
+			return const_cast<PEHeader*>(this)->getSectionHeader(name);
+		}
+
 		SectionHeader& getSectionHeaderFromVa(std::uint32_t va) {
 			static SectionHeader dummy{}; 
 			
-			for (std::uint16_t n = 0; n < m_image->getNumberOfSections(); n++)
-			{
-				if (m_image->m_rawSectionHeaders[n].hasVirtualAddress(va)) {
-					return m_image->m_rawSectionHeaders[n];
-				}
-			}
+			std::uint32_t n = m_sectionIndex.findByRva(va);
+			if (n != SECTION_NOT_FOUND)
+				return m_image->m_rawSectionHeaders[n];
 
 			return dummy;
 		}
 
+		const SectionHeader& getSectionHeaderFromVa(std::uint32_t va) const {
+			return const_cast<PEHeader*>(this)->getSectionHeaderFromVa(va);
+		}
+
 		SectionHeader& getSectionHeaderFromOffset(std::uint32_t offset) {
 			static SectionHeader dummy{};
 
-			for (std::uint16_t n = 0; n < m_image->getNumberOfSections(); n++)
-			{
-				if (m_image->m_rawSectionHeaders[n].hasOffset(offset)) {
-					return m_image->m_rawSectionHeaders[n];
-				}
-			}
+			std::uint32_t n = m_sectionIndex.findByOffset(offset);
+			if (n != SECTION_NOT_FOUND)
+				return m_image->m_rawSectionHeaders[n];
 
 			return dummy;
 		}
 
-
+		const SectionHeader& getSectionHeaderFromOffset(std::uint32_t offset) const {
+			return const_cast<PEHeader*>(this)->getSectionHeaderFromOffset(offset);
+		}
 
 		//! Calculate the number of directories present (not NumberOfRvaAndSizes)
 		std::uint32_t getDirectoryCount() const {
 			return getOptionalHdr().getDirectoryCount();
 		}
 
+		//! Sorted section intervals used for address translation
+		const SectionIndex& getSectionIndex() const {
+			return m_sectionIndex;
+		}
+
 		//! Convert a relative virtual address to a file offset
-		std::uint32_t rvaToOffset(std::uint32_t rva) {
-			SectionHeader const& sec { getSectionHeaderFromVa(rva) };
+		std::uint32_t rvaToOffset(std::uint32_t rva) const {
+			std::uint32_t offset = m_sectionIndex.rvaToOffset(rva);
 			//
 			// Did we get one?
-			if (sec.getName() != ".dummy") {
-				return sec.getPtrToRawData() + rva - sec.getVirtualAddress();
-			}
-
-			return 0ul;
+			return offset != SECTION_NOT_FOUND ? offset : 0ul;
 		}
 
 		//! Convert a file offset back to a relative virtual address
-		std::uint32_t offsetToRva(std::uint32_t offset) {
-			SectionHeader const& sec{ getSectionHeaderFromOffset(offset) };
+		std::uint32_t offsetToRva(std::uint32_t offset) const {
+			std::uint32_t rva = m_sectionIndex.offsetToRva(offset);
 			//
 			// Did we get one?
-			if (sec.getName() != ".dummy") {
-				return (sec.getVirtualAddress() + offset) - sec.getPtrToRawData();
-			}
-
-			return 0ul;
+			return rva != SECTION_NOT_FOUND ? rva : 0ul;
 		}
 		 
+		//! Convert a batch of relative virtual addresses to file offsets (0 on a miss, like rvaToOffset)
+		//! Only min(rvas.size(), offsets.size()) entries are converted.
+		void rvaToOffset(std::span<const std::uint32_t> rvas, std::span<std::uint32_t> offsets) const {
+			m_sectionIndex.rvaTable().translateMany(rvas.data(), offsets.data(), (std::min)(rvas.size(), offsets.size()), 0ul);
+		}
+
+		//! Convert a batch of file offsets back to relative virtual addresses (0 on a miss, like offsetToRva)
+		void offsetToRva(std::span<const std::uint32_t> offsets, std::span<std::uint32_t> rvas) const {
+			m_sectionIndex.offsetTable().translateMany(offsets.data(), rvas.data(), (std::min)(offsets.size(), rvas.size()), 0ul);
+		}
+
 		//! Convert a rel. virtual address to a virtual address
 		detail::Image_t<bitsize>::Address_t rvaToVa(std::uint32_t rva) const {
 			return m_OptionalHeader.getImageBase() + rva;
@@ -164,6 +181,12 @@ namespace pepp
 			m_PEHdr = reinterpret_cast<decltype(m_PEHdr)>(m_image->base() + m_image->m_MZHeader->e_lfanew);
 			m_FileHeader._setup(image);
 			m_OptionalHeader._setup(image);
+			m_sectionIndex.clear();
+		}
+
+		//! (Re)build the section index, needed whenever section headers change
+		void _indexSections() {
+			m_sectionIndex.build(m_image->m_rawSectionHeaders, m_FileHeader.getNumberOfSections());
 		}
 	};
 }
\ No newline at end of file
@@ -5,21 +5,43 @@
 #include <vector>
 #include <string>
 #include <string_view>
+#include <span>
+#include <memory>
+#include <algorithm>
 #include <cassert>
 
 #include "misc/File.hpp"
 #include "misc/NonCopyable.hpp"
 #include "misc/ByteVector.hpp"
+#include "misc/ByteView.hpp"
+#include "misc/MappedFile.hpp"
 #include "misc/Concept.hpp"
 #include "misc/Address.hpp"
+#include "misc/ThreadPool.hpp"
+#include "misc/Md5.hpp"
+
+#include "PEUtil.hpp"
+
+#include "CompiledPattern.hpp"
+#include "PatternSet.hpp"
+#include "PaddingRuns.hpp"
 
 #include "Image.hpp"
+#include "ImageView.hpp"
+#include "SectionIndex.hpp"
+#include "FreeSpaceAllocator.hpp"
 #include "PEHeader.hpp"
 #include "SectionHeader.hpp"
 #include "FileHeader.hpp"
 #include "OptionalHeader.hpp"
 #include "ExportDirectory.hpp"
+#include "ExportBuilder.hpp"
+#include "ExportSymbolIndex.hpp"
+#include "ExportResolver.hpp"
+#include "ImportTable.hpp"
 #include "ImportDirectory.hpp"
+#include "ImportBuilder.hpp"
+#include "DelayImportDirectory.hpp"
 #include "RelocationDirectory.hpp"
-#include "PEUtil.hpp"
+#include "RelocationBuilder.hpp"
 
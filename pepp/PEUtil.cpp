@@ -1,21 +1,513 @@
 #include "PELibrary.hpp"
 
-#include <DbgHelp.h>
-#pragma comment(lib, "dbghelp.lib")
+#include <charconv>
+#include <cstring>
 
 using namespace pepp;
 
+namespace
+{
+	//
+	// Name only undecorator for MSVC mangled names. Handles scopes (with back references), constructors,
+	// destructors, operators and the compiler generated specials (`vftable' ..), anonymous namespaces and
+	// templates with simple type or integer arguments. Anything else fails, the caller keeps the mangled name.
+	// Works on a fixed scratch buffer, nothing is allocated. Nesting is limited, names come from untrusted images.
+	class Undecorator
+	{
+		static constexpr std::size_t max_parts = 32;
+		static constexpr std::size_t max_names = 10;
+		// Nested names, templates and types, every level keeps its fragment tables on the stack
+		static constexpr std::size_t max_depth = 32;
+
+		std::string_view	m_in;
+		std::size_t			m_pos = 0;
+		bool				m_ok = true;
+		char				m_scratch[4096];
+		std::size_t			m_used = 0;
+		// Name fragments a digit can refer back to
+		std::string_view	m_names[max_names];
+		std::size_t			m_nameCount = 0;
+		std::size_t			m_depth = 0;
+
+		//! One level of nesting for as long as it lives, fails the undecoration past max_depth
+		class Nesting
+		{
+			Undecorator& m_self;
+		public:
+			explicit Nesting(Undecorator& self) : m_self(self) {
+				if (++m_self.m_depth > max_depth)
+					m_self._fail();
+			}
+
+			~Nesting() {
+				m_self.m_depth--;
+			}
+		};
+	public:
+		explicit Undecorator(std::string_view mangled) : m_in(mangled) {}
+
+		//! Fully qualified name, empty on failure
+		std::string_view run()
+		{
+			// Names longer than the scratch buffer are rejected up front.
+			if (m_in.size() > sizeof(m_scratch) || !_eat("?"))
+				return {};
+
+			enum { Plain, Constructor, Destructor } kind = Plain;
+			std::string_view name;
+
+			if (_eat("?$"))
+			{
+				name = _template();
+			}
+			else if (_eat("?"))
+			{
+				if (_eat("0"))
+					kind = Constructor;
+				else if (_eat("1"))
+					kind = Destructor;
+				else
+					name = _operator();
+			}
+			else
+			{
+				name = _identifier();
+				_remember(name);
+			}
+
+			std::string_view parts[max_parts];
+			std::size_t count = _scope(parts);
+
+			if (kind != Plain)
+			{
+				// Constructors and destructors are named after their class.
+				if (count == 0)
+					return {};
+				name = kind == Constructor ? parts[0] : _append({ "~", parts[0] });
+			}
+
+			if (!m_ok)
+				return {};
+
+			std::string_view result = _join(parts, count, name);
+			return m_ok ? result : std::string_view{};
+		}
+
+	private:
+		bool _fail()
+		{
+			m_ok = false;
+			return false;
+		}
+
+		bool _eat(std::string_view token)
+		{
+			if (!m_ok || m_in.substr(m_pos, token.size()) != token)
+				return false;
+			m_pos += token.size();
+			return true;
+		}
+
+		char _next()
+		{
+			if (!m_ok || m_pos >= m_in.size())
+			{
+				_fail();
+				return '\0';
+			}
+			return m_in[m_pos++];
+		}
+
+		char _peek() const
+		{
+			return m_ok && m_pos < m_in.size() ? m_in[m_pos] : '\0';
+		}
+
+		//! Concatenate into the scratch buffer
+		std::string_view _append(std::initializer_list<std::string_view> strings)
+		{
+			std::size_t begin = m_used;
+
+			for (std::string_view str : strings)
+			{
+				if (str.size() > sizeof(m_scratch) - m_used)
+				{
+					_fail();
+					return {};
+				}
+
+				std::memcpy(m_scratch + m_used, str.data(), str.size());
+				m_used += str.size();
+			}
+
+			return std::string_view(m_scratch + begin, m_used - begin);
+		}
+
+		void _remember(std::string_view name)
+		{
+			if (m_nameCount < max_names)
+				m_names[m_nameCount++] = name;
+		}
+
+		//! Plain name up to (and eating) the next '@'
+		std::string_view _identifier()
+		{
+			std::size_t end = m_in.find('@', m_pos);
+			if (!m_ok || end == std::string_view::npos || end == m_pos)
+			{
+				_fail();
+				return {};
+			}
+
+			std::string_view name = m_in.substr(m_pos, end - m_pos);
+			m_pos = end + 1;
+			return name;
+		}
+
+		//! One scope fragment
+		std::string_view _fragment()
+		{
+			char c = _peek();
+
+			if (c >= '0' && c <= '9')
+			{
+				m_pos++;
+				if (static_cast<std::size_t>(c - '0') >= m_nameCount)
+				{
+					_fail();
+					return {};
+				}
+				return m_names[c - '0'];
+			}
+
+			if (_eat("?$"))
+			{
+				std::string_view name = _template();
+				_remember(name);
+				return name;
+			}
+
+			if (_eat("?A"))
+			{
+				_identifier();
+				return "`anonymous namespace'";
+			}
+
+			if (c == '?')
+			{
+				_fail();
+				return {};
+			}
+
+			std::string_view name = _identifier();
+			_remember(name);
+			return name;
+		}
+
+		//! Scope fragments up to the terminating '@', innermost first
+		std::size_t _scope(std::string_view* parts)
+		{
+			std::size_t count = 0;
+
+			while (m_ok && !_eat("@"))
+			{
+				if (count == max_parts)
+				{
+					_fail();
+					break;
+				}
+				parts[count++] = _fragment();
+			}
+
+			return count;
+		}
+
+		//! parts (innermost first) + name as "outer::inner::name"
+		std::string_view _join(const std::string_view* parts, std::size_t count, std::string_view name)
+		{
+			std::size_t begin = m_used;
+
+			for (std::size_t i = count; i > 0; i--)
+				_append({ parts[i - 1], "::" });
+			_append({ name });
+
+			return m_ok ? std::string_view(m_scratch + begin, m_used - begin) : std::string_view{};
+		}
+
+		std::string_view _qualifiedName()
+		{
+			Nesting nesting(*this);
+			if (!m_ok)
+				return {};
+
+			std::string_view name = _fragment();
+			std::string_view parts[max_parts];
+			std::size_t count = _scope(parts);
+
+			return _join(parts, count, name);
+		}
+
+		//! "name<args>", after "?$". Template arguments have their own back references.
+		std::string_view _template()
+		{
+			Nesting nesting(*this);
+			if (!m_ok)
+				return {};
+
+			std::string_view saved[max_names];
+			std::size_t savedCount = m_nameCount;
+			std::copy(std::begin(m_names), std::end(m_names), saved);
+			m_nameCount = 0;
+
+			std::string_view name = _identifier();
+			_remember(name);
+
+			std::string_view args[max_parts];
+			std::size_t count = 0;
+
+			while (m_ok && !_eat("@"))
+			{
+				std::string_view arg = _templateArgument();
+				if (arg.empty())
+					continue;
+
+				if (count == max_parts)
+				{
+					_fail();
+					break;
+				}
+				args[count++] = arg;
+			}
+
+			std::copy(std::begin(saved), std::end(saved), m_names);
+			m_nameCount = savedCount;
+
+			std::size_t begin = m_used;
+			_append({ name, "<" });
+			for (std::size_t i = 0; i < count; i++)
+				_append({ i ? "," : "", args[i] });
+			// MSVC keeps closing brackets apart: "a<b<int> >".
+			_append({ (count && args[count - 1].back() == '>') ? " >" : ">" });
+
+			return m_ok ? std::string_view(m_scratch + begin, m_used - begin) : std::string_view{};
+		}
+
+		//! One template argument, empty for empty packs
+		std::string_view _templateArgument()
+		{
+			if (_eat("$0"))
+			{
+				std::int64_t value = _number();
+				char digits[24];
+				auto [end, ec] = std::to_chars(std::begin(digits), std::end(digits), value);
+				return _append({ std::string_view(digits, end - digits) });
+			}
+
+			if (_eat("$$V") || _eat("$$Z"))
+				return {};
+
+			return _type();
+		}
+
+		//! Encoded number: 0-9 is 1-10, otherwise hex digits A-P up to '@', '?' negates
+		std::int64_t _number()
+		{
+			bool negative = _eat("?");
+			std::int64_t value = 0;
+			char c = _next();
+
+			if (c >= '0' && c <= '9')
+			{
+				value = c - '0' + 1;
+			}
+			else
+			{
+				for (; c != '@' && m_ok; c = _next())
+				{
+					if (c < 'A' || c > 'P')
+					{
+						_fail();
+						break;
+					}
+					value = value * 16 + (c - 'A');
+				}
+			}
+
+			return negative ? -value : value;
+		}
+
+		std::string_view _type()
+		{
+			Nesting nesting(*this);
+			if (!m_ok)
+				return {};
+
+			std::string_view star;
+			bool constPointer = false;
+
+			if (_eat("$$Q"))
+			{
+				star = "&&";
+			}
+			else
+			{
+				switch (_next())
+				{
+				case 'C': return "signed char";
+				case 'D': return "char";
+				case 'E': return "unsigned char";
+				case 'F': return "short";
+				case 'G': return "unsigned short";
+				case 'H': return "int";
+				case 'I': return "unsigned int";
+				case 'J': return "long";
+				case 'K': return "unsigned long";
+				case 'M': return "float";
+				case 'N': return "double";
+				case 'O': return "long double";
+				case 'X': return "void";
+				case '_':
+					switch (_next())
+					{
+					case 'D': return "__int8";
+					case 'E': return "unsigned __int8";
+					case 'F': return "__int16";
+					case 'G': return "unsigned __int16";
+					case 'H': return "__int32";
+					case 'I': return "unsigned __int32";
+					case 'J': return "__int64";
+					case 'K': return "unsigned __int64";
+					case 'N': return "bool";
+					case 'S': return "char16_t";
+					case 'U': return "char32_t";
+					case 'W': return "wchar_t";
+					}
+					break;
+				case 'T': return _append({ "union ", _qualifiedName() });
+				case 'U': return _append({ "struct ", _qualifiedName() });
+				case 'V': return _append({ "class ", _qualifiedName() });
+				case 'W':
+					if (_eat("4"))
+						return _append({ "enum ", _qualifiedName() });
+					break;
+				case 'A': star = "&"; break;
+				case 'P': star = "*"; break;
+				case 'Q': star = "*"; constPointer = true; break;
+				}
+			}
+
+			if (star.empty())
+			{
+				_fail();
+				return {};
+			}
+
+			// __ptr64 / __unaligned / __restrict, not part of a name only undecoration
+			while (_eat("E") || _eat("F") || _eat("I"))
+				;
+
+			std::string_view cv;
+			switch (_next())
+			{
+			case 'A': break;
+			case 'B': cv = " const"; break;
+			case 'C': cv = " volatile"; break;
+			case 'D': cv = " const volatile"; break;
+			default:
+				_fail();
+				return {};
+			}
+
+			std::string_view pointee = _type();
+			return _append({ pointee, cv, " ", star, constPointer ? " const" : "" });
+		}
+
+		//! Operator or compiler generated name after "??"
+		std::string_view _operator()
+		{
+			static constexpr std::pair<std::string_view, std::string_view> operators[] = {
+				{ "2", "operator new" }, { "3", "operator delete" }, { "4", "operator=" }, { "5", "operator>>" },
+				{ "6", "operator<<" }, { "7", "operator!" }, { "8", "operator==" }, { "9", "operator!=" },
+				{ "A", "operator[]" }, { "C", "operator->" }, { "D", "operator*" }, { "E", "operator++" },
+				{ "F", "operator--" }, { "G", "operator-" }, { "H", "operator+" }, { "I", "operator&" },
+				{ "J", "operator->*" }, { "K", "operator/" }, { "L", "operator%" }, { "M", "operator<" },
+				{ "N", "operator<=" }, { "O", "operator>" }, { "P", "operator>=" }, { "Q", "operator," },
+				{ "R", "operator()" }, { "S", "operator~" }, { "T", "operator^" }, { "U", "operator|" },
+				{ "V", "operator&&" }, { "W", "operator||" }, { "X", "operator*=" }, { "Y", "operator+=" },
+				{ "Z", "operator-=" }, { "_0", "operator/=" }, { "_1", "operator%=" }, { "_2", "operator>>=" },
+				{ "_3", "operator<<=" }, { "_4", "operator&=" }, { "_5", "operator|=" }, { "_6", "operator^=" },
+				{ "_7", "`vftable'" }, { "_8", "`vbtable'" }, { "_9", "`vcall'" }, { "_A", "`typeof'" },
+				{ "_B", "`local static guard'" }, { "_D", "`vbase destructor'" }, { "_E", "`vector deleting destructor'" },
+				{ "_F", "`default constructor closure'" }, { "_G", "`scalar deleting destructor'" },
+				{ "_H", "`vector constructor iterator'" }, { "_I", "`vector destructor iterator'" },
+				{ "_J", "`vector vbase constructor iterator'" }, { "_K", "`virtual displacement map'" },
+				{ "_L", "`eh vector constructor iterator'" }, { "_M", "`eh vector destructor iterator'" },
+				{ "_N", "`eh vector vbase constructor iterator'" }, { "_O", "`copy constructor closure'" },
+				{ "_S", "`local vftable'" }, { "_T", "`local vftable constructor closure'" },
+				{ "_U", "operator new[]" }, { "_V", "operator delete[]" }
+			};
+
+			for (auto const& [code, name] : operators)
+			{
+				if (_eat(code))
+					return name;
+			}
+
+			// Conversion operators need the return type, RTTI names a type descriptor..
+			_fail();
+			return {};
+		}
+	};
+}
+
+std::size_t pepp::DemangleName(std::string_view mangled_name, char* buffer, std::size_t size)
+{
+	Undecorator undecorator(mangled_name);
+	std::string_view name = undecorator.run();
+
+	if (name.empty())
+		name = mangled_name;
+
+	if (size != 0)
+	{
+		std::size_t length = (std::min)(name.size(), size - 1);
+		std::memcpy(buffer, name.data(), length);
+		buffer[length] = '\0';
+	}
+
+	return name.size();
+}
+
 std::string pepp::DemangleName(std::string_view mangled_name)
 {
-    //
-    // TODO: Don't rely on DbgHelp??
-    char undecorated_name[1024];
-    UnDecorateSymbolName(
-        mangled_name.data(),
-        undecorated_name,
-        sizeof undecorated_name,
-        UNDNAME_32_BIT_DECODE | UNDNAME_NAME_ONLY);
-    
-    return undecorated_name;
+	Undecorator undecorator(mangled_name);
+	std::string_view name = undecorator.run();
+
+	return std::string(name.empty() ? mangled_name : name);
+}
+
+std::string DemangleCache::get(std::uint32_t rva, std::string_view mangled_name)
+{
+	// Plain names demangle to themselves, no need to keep them.
+	if (mangled_name.empty() || mangled_name[0] != '?')
+		return std::string(mangled_name);
+
+	{
+		std::shared_lock<std::shared_mutex> lock(m_lock);
+
+		auto it = m_names.find(rva);
+		if (it != m_names.end())
+			return it->second;
+	}
+
+	std::string name = DemangleName(mangled_name);
+
+	std::unique_lock<std::shared_mutex> lock(m_lock);
+	return m_names.try_emplace(rva, std::move(name)).first->second;
 }
 
+void DemangleCache::clear()
+{
+	std::unique_lock<std::shared_mutex> lock(m_lock);
+	m_names.clear();
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <unordered_map>
+#include <shared_mutex>
+
 
 namespace pepp
 {
@@ -23,6 +26,25 @@ namespace pepp
 		return align(v, PAGE_SIZE);
 	}
 
-	//! Demangle a mangled name (MS supplied)
+	//! Undecorate an MSVC mangled name, name only (what UnDecorateSymbolName gives with UNDNAME_NAME_ONLY),
+	//! e.g "?foo@bar@@YAXXZ" -> "bar::foo". Names that aren't mangled, or use encodings the undecorator
+	//! doesn't handle, come back unchanged.
+	//! Writes at most `size` - 1 chars plus a terminator, returns the full length (like snprintf).
+	std::size_t DemangleName(std::string_view mangled_name, char* buffer, std::size_t size);
 	std::string DemangleName(std::string_view mangled_name);
+
+	//! Demangled names keyed by the rva of the mangled name, so repeated walks over a table demangle each name once.
+	//! Safe to use from several threads.
+	class DemangleCache : pepp::msc::NonCopyable
+	{
+		std::unordered_map<std::uint32_t, std::string>	m_names;
+		mutable std::shared_mutex						m_lock;
+	public:
+		DemangleCache() = default;
+
+		//! Demangled form of `mangled_name`, which lives at `rva`
+		std::string get(std::uint32_t rva, std::string_view mangled_name);
+
+		void clear();
+	};
 }
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "PELibrary.hpp"
+#include "misc/Simd.hpp"
+#include <bit>
+
+using namespace pepp;
+
+namespace
+{
+	std::size_t findScalar(const std::uint8_t* data, std::size_t from, std::size_t to, std::uint8_t value, bool equal) noexcept
+	{
+		for (std::size_t i = from; i < to; i++)
+		{
+			if ((data[i] == value) == equal)
+				return i;
+		}
+		return to;
+	}
+
+#if PEPP_HAS_SSE2
+	std::size_t findSse2(const std::uint8_t* data, std::size_t from, std::size_t to, std::uint8_t value, bool equal) noexcept
+	{
+		const __m128i v = _mm_set1_epi8((char)value);
+		const std::uint32_t flip = equal ? 0 : 0xFFFF;
+		std::size_t i = from;
+
+		for (; to - i >= 16; i += 16)
+		{
+			std::uint32_t mask = (std::uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + i)), v)) ^ flip;
+			if (mask)
+				return i + std::countr_zero(mask);
+		}
+
+		return findScalar(data, i, to, value, equal);
+	}
+#endif
+
+#if PEPP_ARCH_X86
+	PEPP_TARGET("avx2")
+	std::size_t findAvx2(const std::uint8_t* data, std::size_t from, std::size_t to, std::uint8_t value, bool equal) noexcept
+	{
+		const __m256i v = _mm256_set1_epi8((char)value);
+		const std::uint32_t flip = equal ? 0 : 0xFFFFFFFF;
+		std::size_t i = from;
+
+		//
+		// Two vectors per step, long runs (and long stretches without the value) are the common case.
+		for (; to - i >= 64; i += 64)
+		{
+			__m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + i)), v);
+			__m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + i + 32)), v);
+			std::uint64_t mask = ((std::uint64_t)((std::uint32_t)_mm256_movemask_epi8(b) ^ flip) << 32) | ((std::uint32_t)_mm256_movemask_epi8(a) ^ flip);
+			if (mask)
+				return i + std::countr_zero(mask);
+		}
+
+		for (; to - i >= 32; i += 32)
+		{
+			std::uint32_t mask = (std::uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + i)), v)) ^ flip;
+			if (mask)
+				return i + std::countr_zero(mask);
+		}
+
+		return findScalar(data, i, to, value, equal);
+	}
+#endif
+
+	using FindFn_t = std::size_t(*)(const std::uint8_t*, std::size_t, std::size_t, std::uint8_t, bool) noexcept;
+
+	FindFn_t selectFind() noexcept
+	{
+#if PEPP_ARCH_X86
+		if (simd::cpuFeatures().avx2)
+			return findAvx2;
+#endif
+#if PEPP_HAS_SSE2
+		return findSse2;
+#else
+		return findScalar;
+#endif
+	}
+}
+
+std::size_t PaddingRuns::find(const std::uint8_t* data, std::size_t from, std::size_t to, std::uint8_t value, bool equal) noexcept
+{
+	static const FindFn_t fn = selectFind();
+
+	if (from >= to)
+		return to;
+
+	return fn(data, from, to, value, equal);
+}
+
+PaddingRuns::PaddingRuns(const std::uint8_t* data, std::uint32_t begin, std::uint32_t end, std::uint8_t value, std::size_t min_size)
+	: m_data(data)
+	, m_begin(begin)
+	, m_end(end < begin ? begin : end)
+	, m_minSize(min_size == 0 ? 1 : static_cast<std::uint32_t>((std::min)(min_size, static_cast<std::size_t>(0xffffffff))))
+	, m_value(value)
+{
+}
+
+PaddingRun_t PaddingRuns::next(std::uint32_t from) const noexcept
+{
+	std::size_t i = (std::max)(from, m_begin);
+
+	while (i < m_end)
+	{
+		std::size_t start = find(m_data, i, m_end, m_value, true);
+		if (start >= m_end)
+			break;
+
+		if (m_end - start < m_minSize)
+			break;
+
+		//
+		// Short runs are skipped without looking at every byte of them: if the byte at start + min - 1
+		// isn't the value, no long enough run starts at or before it.
+		if (m_data[start + m_minSize - 1] != m_value)
+		{
+			i = start + m_minSize;
+			continue;
+		}
+
+		std::size_t stop = find(m_data, start, m_end, m_value, false);
+
+		if (stop - start >= m_minSize)
+			return { static_cast<std::uint32_t>(start), static_cast<std::uint32_t>(stop - start) };
+
+		i = stop;
+	}
+
+	return { m_end, 0 };
+}
+
+PaddingRuns::Iterator::Iterator(const PaddingRuns* runs, std::uint32_t from)
+	: m_runs(runs)
+{
+	m_run = m_runs->next(from);
+	if (m_run.size == 0)
+		m_runs = nullptr;
+}
+
+PaddingRuns::Iterator& PaddingRuns::Iterator::operator++()
+{
+	m_run = m_runs->next(m_run.offset + m_run.size);
+	if (m_run.size == 0)
+		m_runs = nullptr;
+	return *this;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <iterator>
+
+namespace pepp
+{
+	//! One run of a repeated byte, as (file offset, length)
+	struct PaddingRun_t
+	{
+		std::uint32_t	offset;
+		std::uint32_t	size;
+
+		bool operator==(const PaddingRun_t&) const = default;
+	};
+
+	///
+	// - class PaddingRuns
+	// - Every run of a byte value at least `min_size` bytes long inside a buffer range (code caves, padding..).
+	// - Runs are found lazily while iterating with a vectorized scan, so callers can pick the
+	// - best fitting run in one pass. The range doesn't own the bytes, it must not outlive them.
+	///
+	class PaddingRuns
+	{
+		const std::uint8_t*	m_data = nullptr;
+		std::uint32_t		m_begin = 0;
+		std::uint32_t		m_end = 0;
+		std::uint32_t		m_minSize = 1;
+		std::uint8_t		m_value = 0;
+	public:
+		class Iterator
+		{
+			const PaddingRuns*	m_runs = nullptr;
+			PaddingRun_t		m_run{};
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = PaddingRun_t;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const PaddingRun_t*;
+			using reference = const PaddingRun_t&;
+
+			Iterator() = default;
+			Iterator(const PaddingRuns* runs, std::uint32_t from);
+
+			reference operator*() const { return m_run; }
+			pointer operator->() const { return &m_run; }
+
+			Iterator& operator++();
+			Iterator operator++(int) {
+				Iterator it = *this;
+				++*this;
+				return it;
+			}
+
+			bool operator==(const Iterator& rhs) const {
+				return m_runs == rhs.m_runs && (m_runs == nullptr || m_run.offset == rhs.m_run.offset);
+			}
+			bool operator!=(const Iterator& rhs) const {
+				return !(*this == rhs);
+			}
+		};
+
+		PaddingRuns() = default;
+
+		//! Runs of `value` in [data + begin, data + end), runs are cut at the range bounds
+		PaddingRuns(const std::uint8_t* data, std::uint32_t begin, std::uint32_t end, std::uint8_t value, std::size_t min_size = 1);
+
+		Iterator begin() const { return Iterator(this, m_begin); }
+		Iterator end() const { return Iterator(); }
+
+		//! First run at or after `from`, size 0 if there is none
+		PaddingRun_t next(std::uint32_t from) const noexcept;
+
+		std::uint8_t value() const noexcept {
+			return m_value;
+		}
+
+		//! First position in [from, to) where (data[i] == value) == `equal`, or `to`
+		static std::size_t find(const std::uint8_t* data, std::size_t from, std::size_t to, std::uint8_t value, bool equal) noexcept;
+	};
+}
@@ -0,0 +1,139 @@
+#include "PELibrary.hpp"
+
+using namespace pepp;
+
+namespace
+{
+	inline bool testBit(const std::uint64_t* bits, std::uint32_t n)
+	{
+		return (bits[n >> 6] >> (n & 63)) & 1;
+	}
+
+	inline void setBit(std::uint64_t* bits, std::uint32_t n)
+	{
+		bits[n >> 6] |= std::uint64_t(1) << (n & 63);
+	}
+}
+
+bool PatternSet::add(std::int32_t id, std::string_view pattern)
+{
+	return add(id, CompiledPattern(pattern));
+}
+
+bool PatternSet::add(std::int32_t id, const CompiledPattern& pattern)
+{
+	if (!pattern.valid())
+		return false;
+
+	const std::uint8_t* bytes = pattern.bytes();
+	const std::uint8_t* mask = pattern.mask();
+	Anchor_t anchor{ 0, static_cast<std::uint32_t>(m_patterns.size()), 0 };
+	std::uint32_t bestWeight = 0xffffffff;
+
+	//
+	// Prefer the least common pair of adjacent concrete bytes, it filters far better than one byte.
+	for (std::size_t i = 0; i + 1 < pattern.size(); i++)
+	{
+		if (!mask[i] || !mask[i + 1])
+			continue;
+
+		std::uint32_t weight = CompiledPattern::byteWeight(bytes[i]) + CompiledPattern::byteWeight(bytes[i + 1]);
+		if (weight < bestWeight)
+		{
+			bestWeight = weight;
+			anchor.key = static_cast<std::uint16_t>(bytes[i] | (bytes[i + 1] << 8));
+			anchor.offset = static_cast<std::uint32_t>(i);
+		}
+	}
+
+	if (bestWeight != 0xffffffff)
+	{
+		if (m_pairFilter.empty())
+			m_pairFilter.resize(0x10000 / 64);
+
+		setBit(m_pairFilter.data(), anchor.key);
+		_insertAnchor(m_pairAnchors, anchor);
+	}
+	else
+	{
+		anchor.offset = static_cast<std::uint32_t>(pattern.anchor());
+		anchor.key = bytes[anchor.offset];
+
+		setBit(m_byteFilter, anchor.key);
+		_insertAnchor(m_byteAnchors, anchor);
+	}
+
+	m_patterns.emplace_back(id, pattern);
+	m_maxPatternSize = (std::max)(m_maxPatternSize, pattern.size());
+	return true;
+}
+
+void PatternSet::clear()
+{
+	m_patterns.clear();
+	m_pairAnchors.clear();
+	m_byteAnchors.clear();
+	m_pairFilter.clear();
+	std::memset(m_byteFilter, 0, sizeof(m_byteFilter));
+	m_maxPatternSize = 0;
+}
+
+void PatternSet::_insertAnchor(std::vector<Anchor_t>& anchors, const Anchor_t& anchor)
+{
+	auto it = std::upper_bound(anchors.begin(), anchors.end(), anchor.key,
+		[](std::uint16_t key, const Anchor_t& a) { return key < a.key; });
+
+	anchors.insert(it, anchor);
+}
+
+void PatternSet::_verify(const std::vector<Anchor_t>& anchors, std::uint16_t key, const std::uint8_t* data, std::size_t size, std::size_t pos, std::vector<std::uint64_t>& hits) const
+{
+	auto it = std::lower_bound(anchors.begin(), anchors.end(), key,
+		[](const Anchor_t& a, std::uint16_t key) { return a.key < key; });
+
+	for (; it != anchors.end() && it->key == key; ++it)
+	{
+		if (pos < it->offset)
+			continue;
+
+		const std::size_t start = pos - it->offset;
+		const CompiledPattern& pattern = m_patterns[it->pattern].second;
+
+		if (pattern.size() <= size - start && pattern.matches(data + start))
+			hits.push_back((static_cast<std::uint64_t>(start) << 32) | it->pattern);
+	}
+}
+
+void PatternSet::scan(const std::uint8_t* data, std::size_t size, std::vector<std::pair<std::int32_t, std::uint32_t>>& out, std::uint32_t base) const
+{
+	if (m_patterns.empty() || size == 0)
+		return;
+
+	// (start << 32 | pattern index), sorts into offset order then insertion order.
+	std::vector<std::uint64_t> hits;
+
+	const bool hasPairs = !m_pairAnchors.empty();
+	const bool hasBytes = !m_byteAnchors.empty();
+	const std::uint64_t* pairFilter = m_pairFilter.data();
+
+	//
+	// Single pass, every position is checked against both key filters.
+	for (std::size_t pos = 0; pos < size; pos++)
+	{
+		if (hasBytes && testBit(m_byteFilter, data[pos]))
+			_verify(m_byteAnchors, data[pos], data, size, pos, hits);
+
+		if (hasPairs && pos + 1 < size)
+		{
+			std::uint16_t key = static_cast<std::uint16_t>(data[pos] | (data[pos + 1] << 8));
+			if (testBit(pairFilter, key))
+				_verify(m_pairAnchors, key, data, size, pos, hits);
+		}
+	}
+
+	std::sort(hits.begin(), hits.end());
+
+	out.reserve(out.size() + hits.size());
+	for (std::uint64_t hit : hits)
+		out.emplace_back(m_patterns[static_cast<std::uint32_t>(hit)].first, base + static_cast<std::uint32_t>(hit >> 32));
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+namespace pepp
+{
+	///
+	// - class PatternSet
+	// - Many CompiledPatterns matched together in a single pass (filter-then-verify).
+	// - Every pattern is keyed by its least common pair of adjacent concrete bytes (or single byte if
+	// - it has no such pair), a bitmap over the keys rejects most positions with one lookup and only
+	// - the patterns sharing a key are verified.
+	// - Scanning doesn't modify the set, so one set can be shared by any number of images/threads
+	// - as long as nothing is added while scans are running.
+	///
+	class PatternSet
+	{
+		struct Anchor_t
+		{
+			std::uint16_t	key;
+			std::uint32_t	pattern;
+			//! Position of the key bytes inside the pattern
+			std::uint32_t	offset;
+		};
+
+		std::vector<std::pair<std::int32_t, CompiledPattern>>	m_patterns;
+		//! Anchors sorted by key, 2-byte keys are little endian (data[p] | data[p + 1] << 8)
+		std::vector<Anchor_t>		m_pairAnchors;
+		std::vector<Anchor_t>		m_byteAnchors;
+		std::vector<std::uint64_t>	m_pairFilter;
+		std::uint64_t				m_byteFilter[4]{};
+		std::size_t					m_maxPatternSize = 0;
+	public:
+		PatternSet() = default;
+
+		//! Add a pattern reported as `id`, returns false if it doesn't compile (it is not added then)
+		bool add(std::int32_t id, std::string_view pattern);
+		bool add(std::int32_t id, const CompiledPattern& pattern);
+
+		void clear();
+
+		//! Number of patterns in the set
+		std::size_t size() const noexcept {
+			return m_patterns.size();
+		}
+
+		bool empty() const noexcept {
+			return m_patterns.empty();
+		}
+
+		//! Length of the longest pattern, matches never span more than this
+		std::size_t maxPatternSize() const noexcept {
+			return m_maxPatternSize;
+		}
+
+		const std::vector<std::pair<std::int32_t, CompiledPattern>>& patterns() const noexcept {
+			return m_patterns;
+		}
+
+		//! Append every (id, base + offset) match fully inside [data, data + size) to `out`.
+		//! Matches are sorted by offset, then by the order patterns were added. Overlapping matches are all reported.
+		void scan(const std::uint8_t* data, std::size_t size, std::vector<std::pair<std::int32_t, std::uint32_t>>& out, std::uint32_t base = 0) const;
+
+	private:
+		static void _insertAnchor(std::vector<Anchor_t>& anchors, const Anchor_t& anchor);
+
+		//! Verify the patterns keyed by `key`, with their key bytes at data + pos
+		void _verify(const std::vector<Anchor_t>& anchors, std::uint16_t key, const std::uint8_t* data, std::size_t size, std::size_t pos, std::vector<std::uint64_t>& hits) const;
+	};
+}
@@ -0,0 +1,246 @@
+#include "PELibrary.hpp"
+
+using namespace pepp;
+
+// Explicit templates.
+template class RelocationBuilder<32>;
+template class RelocationBuilder<64>;
+
+template<unsigned int bitsize>
+RelocationBuilder<bitsize>::RelocationBuilder(Image<bitsize>& image)
+	: m_image(&image)
+{
+}
+
+template<unsigned int bitsize>
+bool RelocationBuilder<bitsize>::add(std::uint32_t rva, RelocationType type)
+{
+	// HIGHADJ takes the next slot as its parameter, which the builder has no way to write.
+	if (type == REL_BASED_ABSOLUTE || type == REL_BASED_HIGHADJ)
+		return false;
+
+	m_entries.push_back({ rva, type });
+	return true;
+}
+
+template<unsigned int bitsize>
+bool RelocationBuilder<bitsize>::addExisting()
+{
+	std::vector<Entry_t> existing;
+
+	bool ok = m_image->getRelocDir().forEachBlock(
+		[&existing](const detail::Image_t<>::RelocationBase_t& reloc, const std::uint16_t* entries, std::uint32_t count)
+		{
+			for (std::uint32_t i = 0; i < count; i++)
+			{
+				BlockEntry entry(reloc.VirtualAddress, entries[i]);
+
+				if (entry.getType() == REL_BASED_HIGHADJ)
+					return false;
+
+				if (entry.getType() != REL_BASED_ABSOLUTE)
+					existing.push_back({ entry.getRva(), entry.getType() });
+			}
+
+			return true;
+		});
+
+	if (!ok)
+		return false;
+
+	m_entries.insert(m_entries.end(), existing.begin(), existing.end());
+	return true;
+}
+
+template<unsigned int bitsize>
+bool RelocationBuilder<bitsize>::remove(std::uint32_t rva)
+{
+	auto it = std::remove_if(m_entries.begin(), m_entries.end(), [rva](const Entry_t& entry) { return entry.rva == rva; });
+	if (it == m_entries.end())
+		return false;
+
+	m_entries.erase(it, m_entries.end());
+	return true;
+}
+
+template<unsigned int bitsize>
+bool RelocationBuilder<bitsize>::build(std::string_view section_name)
+{
+	using RelocationBase_t = detail::Image_t<>::RelocationBase_t;
+
+	constexpr std::uint32_t page_mask = ~0xfffu;
+
+	_normalize();
+
+	// Resizing needs an owned buffer, take it before any offsets are computed.
+	m_image->buffer();
+
+	//
+	// 1) Size: a header per page, entries padded to 4 bytes with an ABSOLUTE entry.
+	std::uint32_t size = 0;
+
+	for (std::size_t n = 0; n < m_entries.size();)
+	{
+		std::size_t end = n;
+		while (end < m_entries.size() && (m_entries[end].rva & page_mask) == (m_entries[n].rva & page_mask))
+			end++;
+
+		size += sizeof(RelocationBase_t) + align(static_cast<std::uint32_t>((end - n) * sizeof(std::uint16_t)), sizeof(std::uint32_t));
+		n = end;
+	}
+
+	if (size == 0)
+	{
+		IMAGE_DATA_DIRECTORY& dir = m_image->getPEHdr().getOptionalHdr().getDataDir(DIRECTORY_ENTRY_BASERELOC);
+		dir.VirtualAddress = 0;
+		dir.Size = 0;
+		m_image->getRelocDir()._setup(m_image);
+		return true;
+	}
+
+	//
+	// 2) Room for the table and a zero terminator (the block walkers stop at it). The old table's section is only
+	// reused if the table is all it holds, anything else gets a new section.
+	const std::uint32_t required = size + sizeof(RelocationBase_t);
+	std::uint16_t index = _findOwnSection();
+
+	if (index != m_image->getNumberOfSections())
+	{
+		SectionHeader& sec = m_image->getSectionHdr(index);
+		const std::uint32_t capacity = (std::min)(sec.getSizeOfRawData(), sec.getVirtualSize());
+
+		if (capacity < required)
+		{
+			// Growing any other section would run into the next one, extendSection() also finds it by name.
+			if (index + 1 != m_image->getNumberOfSections() || &m_image->getSectionHdr(sec.getName()) != &sec ||
+				!m_image->extendSection(sec.getName(), required - capacity))
+				index = m_image->getNumberOfSections();
+		}
+	}
+
+	if (index == m_image->getNumberOfSections())
+	{
+		if (!m_image->appendSection(section_name, required, SCN_MEM_READ | SCN_MEM_DISCARDABLE | SCN_CNT_INITIALIZED_DATA))
+			return false;
+	}
+
+	// The headers live in the buffer, only take references once it is done growing.
+	IMAGE_DATA_DIRECTORY& dir = m_image->getPEHdr().getOptionalHdr().getDataDir(DIRECTORY_ENTRY_BASERELOC);
+	SectionHeader& sec = m_image->getSectionHdr(index);
+	const std::uint32_t offset = sec.getPtrToRawData();
+
+	if (offset + static_cast<std::size_t>(required) > m_image->buffer().size())
+		return false;
+
+	//
+	// 3) Clear the old table (only its own bytes, wherever it is), then write the blocks.
+	if (dir.Size != 0)
+	{
+		std::uint32_t oldOffset = m_image->getPEHdr().rvaToOffset(dir.VirtualAddress);
+
+		if (oldOffset != 0 && oldOffset < m_image->buffer().size())
+			std::memset(&m_image->buffer()[oldOffset], 0, (std::min)(static_cast<std::size_t>(dir.Size), m_image->buffer().size() - oldOffset));
+	}
+
+	std::uint8_t* block = &m_image->buffer()[offset];
+	std::memset(block, 0, required);
+
+	for (std::size_t n = 0; n < m_entries.size();)
+	{
+		RelocationBase_t* reloc = reinterpret_cast<RelocationBase_t*>(block);
+		std::uint16_t* entries = reinterpret_cast<std::uint16_t*>(reloc + 1);
+		std::uint32_t count = 0;
+
+		reloc->VirtualAddress = m_entries[n].rva & page_mask;
+
+		for (; n < m_entries.size() && (m_entries[n].rva & page_mask) == reloc->VirtualAddress; n++)
+			entries[count++] = craftRelocationBlockEntry(m_entries[n].type, static_cast<std::uint16_t>(m_entries[n].rva & ~page_mask));
+
+		// The padding entry (if any) is already zero.
+		reloc->SizeOfBlock = sizeof(RelocationBase_t) + align(count * static_cast<std::uint32_t>(sizeof(std::uint16_t)), sizeof(std::uint32_t));
+		block += reloc->SizeOfBlock;
+	}
+
+	//
+	// 4) Point the directory at the new table.
+	dir.VirtualAddress = sec.getVirtualAddress();
+	dir.Size = size;
+
+	m_image->getRelocDir()._setup(m_image);
+	return true;
+}
+
+template<unsigned int bitsize>
+void RelocationBuilder<bitsize>::_normalize()
+{
+	std::stable_sort(m_entries.begin(), m_entries.end(),
+		[](const Entry_t& lhs, const Entry_t& rhs) { return lhs.rva < rhs.rva; });
+
+	//
+	// Keep the last entry of every rva.
+	std::size_t out = 0;
+
+	for (std::size_t n = 0; n < m_entries.size(); n++)
+	{
+		if (n + 1 < m_entries.size() && m_entries[n + 1].rva == m_entries[n].rva)
+			continue;
+
+		m_entries[out++] = m_entries[n];
+	}
+
+	m_entries.resize(out);
+}
+
+template<unsigned int bitsize>
+std::uint16_t RelocationBuilder<bitsize>::_findOwnSection()
+{
+	const std::uint16_t none = m_image->getNumberOfSections();
+	const IMAGE_DATA_DIRECTORY& dir = m_image->getPEHdr().getOptionalHdr().getDataDir(DIRECTORY_ENTRY_BASERELOC);
+
+	if (dir.VirtualAddress == 0 || dir.Size == 0)
+		return none;
+
+	//
+	// The table has to open the section...
+	std::uint16_t index = none;
+
+	for (std::uint16_t i = 0; i < none; i++)
+	{
+		if (m_image->getSectionHdr(i).getVirtualAddress() == dir.VirtualAddress)
+		{
+			index = i;
+			break;
+		}
+	}
+
+	if (index == none)
+		return none;
+
+	SectionHeader& sec = m_image->getSectionHdr(index);
+	const std::uint32_t begin = sec.getVirtualAddress();
+	const std::uint32_t end = begin + (std::max)(sec.getVirtualSize(), sec.getSizeOfRawData());
+
+	// ...no other directory may point into it...
+	for (int i = 0; i < MAX_DIRECTORY_COUNT; i++)
+	{
+		const IMAGE_DATA_DIRECTORY& other = m_image->getPEHdr().getOptionalHdr().getDataDir(i);
+
+		if (i != DIRECTORY_ENTRY_BASERELOC && other.Size != 0 && other.VirtualAddress >= begin && other.VirtualAddress < end)
+			return none;
+	}
+
+	// ...and everything after it must be padding.
+	const std::size_t rawBegin = sec.getPtrToRawData();
+	const std::size_t rawEnd = (std::min)(rawBegin + sec.getSizeOfRawData(), m_image->buffer().size());
+
+	if (dir.Size > sec.getSizeOfRawData())
+		return none;
+
+	for (std::size_t n = rawBegin + dir.Size; n < rawEnd; n++)
+	{
+		if (m_image->buffer()[n] != 0)
+			return none;
+	}
+
+	return index;
+}
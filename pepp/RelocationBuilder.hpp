@@ -0,0 +1,60 @@
+#pragma once
+
+namespace pepp
+{
+	///
+	// - class RelocationBuilder
+	// - Collects the complete set of base relocations of an image and writes a new relocation directory in one pass:
+	// - fixups sorted and grouped per 4kb page, one block per page padded to 4 bytes, followed by a zero terminator.
+	// - The table is written at the start of the section named `section_name`, which is extended if it is too small
+	// - (only possible for the last section) or appended if the image has none.
+	///
+	template<unsigned int bitsize>
+	class RelocationBuilder : pepp::msc::NonCopyable
+	{
+		struct Entry_t
+		{
+			std::uint32_t		rva;
+			RelocationType		type;
+		};
+
+		Image<bitsize>*			m_image;
+		std::vector<Entry_t>	m_entries;
+	public:
+		//! Type add() uses by default, an address sized fixup
+		static constexpr RelocationType DEFAULT_TYPE = bitsize == 64 ? REL_BASED_DIR64 : REL_BASED_HIGHLOW;
+
+		explicit RelocationBuilder(Image<bitsize>& image);
+
+		//! Queue a fixup, a later one at the same rva replaces it.
+		//! False for ABSOLUTE (padding) and HIGHADJ (needs a parameter slot the builder can't write).
+		bool add(std::uint32_t rva, RelocationType type = DEFAULT_TYPE);
+
+		//! Queue every relocation the image has now, to rebuild the table with a few changes.
+		//! False (queueing nothing) if the existing table runs past the image or has a HIGHADJ entry.
+		bool addExisting();
+
+		//! Drop a queued fixup, false if there is none at `rva`
+		bool remove(std::uint32_t rva);
+
+		//! Write the new relocation directory, replacing the old one.
+		//! Fails (leaving the image untouched) if a new section is needed and can't be appended.
+		bool build(std::string_view section_name = ".reloc");
+
+		//! Number of queued fixups
+		std::size_t size() const noexcept {
+			return m_entries.size();
+		}
+
+		void clear() {
+			m_entries.clear();
+		}
+
+	private:
+		//! Sort by rva, later duplicates winning
+		void _normalize();
+
+		//! Index of the section that holds the current table and nothing else, getNumberOfSections() if there is none
+		std::uint16_t _findOwnSection();
+	};
+}
@@ -47,32 +47,28 @@ std::uint32_t RelocationDirectory<bitsize>::getRemainingFreeBytes() const
 template<unsigned int bitsize>
 bool pepp::RelocationDirectory<bitsize>::changeRelocationType(std::uint32_t rva, RelocationType type)
 {
-	auto base = m_base;
-	std::vector<BlockEntry> entries;
-
-	while (base->VirtualAddress)
-	{
-		int numEntries = getNumEntries(base);
-		std::uint16_t* entry = (std::uint16_t*)(base + 1);
+	std::uint16_t* entry = _findEntry(rva);
+	if (entry == nullptr)
+		return false;
 
-		for (int i = 0; i != numEntries; i++, entry++)
-		{
-			BlockEntry block(base->VirtualAddress, *entry);
-			if (block.getRva() == rva)
-			{
-				*entry = craftRelocationBlockEntry(type, block.getOffset());
-				return true;
-			}
-		}
+	// Same rva, the index stays valid.
+	*entry = craftRelocationBlockEntry(type, BlockEntry(0, *entry).getOffset());
+	return true;
+}
 
-		base = decltype(base)((char*)base + base->SizeOfBlock);
-	}
+template<unsigned int bitsize>
+bool pepp::RelocationDirectory<bitsize>::getRelocationType(std::uint32_t rva, RelocationType& type) const
+{
+	std::uint16_t* entry = _findEntry(rva);
+	if (entry == nullptr)
+		return false;
 
-	return false;
+	type = BlockEntry(0, *entry).getType();
+	return true;
 }
 
 template<unsigned int bitsize>
-std::vector<BlockEntry> RelocationDirectory<bitsize>::getBlockEntries(int blockIdx)
+std::vector<BlockEntry> RelocationDirectory<bitsize>::getBlockEntries(int blockIdx) const
 {
 	auto base = m_base;
 	int count = 0;
@@ -120,7 +116,7 @@ BlockStream RelocationDirectory<bitsize>::createBlock(std::uint32_t rva, std::ui
 	{
 		if (base->VirtualAddress == rva)
 		{
-			return BlockStream(base);
+			return BlockStream(base, &m_indexBuilt);
 		}
 
 		base = decltype(base)((char*)base + base->SizeOfBlock);
@@ -140,8 +136,10 @@ BlockStream RelocationDirectory<bitsize>::createBlock(std::uint32_t rva, std::ui
 	// Set the new block's descriptor
 	base->VirtualAddress = rva;
 	base->SizeOfBlock = size;
+
+	_invalidateIndex();
 	
-	return BlockStream(base);
+	return BlockStream(base, &m_indexBuilt);
 }
 
 template<unsigned int bitsize>
@@ -153,7 +151,7 @@ BlockStream pepp::RelocationDirectory<bitsize>::getBlockStream(std::uint32_t rva
 	while (base->VirtualAddress)
 	{
 		if (base->VirtualAddress == rva)
-			return BlockStream(base);
+			return BlockStream(base, &m_indexBuilt);
 
 		base = decltype(base)((char*)base + base->SizeOfBlock);
 	}
@@ -171,14 +169,14 @@ void pepp::RelocationDirectory<bitsize>::extend(std::uint32_t num_entries)
 	{
 		m_image->extendSection(m_section->getName(), size);
 		//__debugbreak();
+		_invalidateIndex();
 	}
 }
 
 template<unsigned int bitsize>
-void pepp::RelocationDirectory<bitsize>::forEachEntry(std::function<void(BlockEntry&)> Callback)
+void pepp::RelocationDirectory<bitsize>::forEachEntry(std::function<void(BlockEntry&)> Callback) const
 {
 	auto base = m_base;
-	std::vector<BlockEntry> entries;
 
 	while (base->VirtualAddress)
 	{
@@ -198,25 +196,7 @@ void pepp::RelocationDirectory<bitsize>::forEachEntry(std::function<void(BlockEn
 template<unsigned int bitsize>
 bool pepp::RelocationDirectory<bitsize>::isRelocationPresent(std::uint32_t rva) const
 {
-	auto base = m_base;
-	std::vector<BlockEntry> entries;
-
-	while (base->VirtualAddress)
-	{
-		int numEntries = getNumEntries(base);
-		std::uint16_t* entry = (std::uint16_t*)(base + 1);
-
-		for (int i = 0; i != numEntries; i++, entry++)
-		{
-			BlockEntry block(base->VirtualAddress, *entry);
-			if (block.getRva() == rva)
-				return true;
-		}
-
-		base = decltype(base)((char*)base + base->SizeOfBlock);
-	}
-
-	return false;
+	return _findEntry(rva) != nullptr;
 }
 
 template<unsigned int bitsize>
@@ -249,6 +229,7 @@ void pepp::RelocationDirectory<bitsize>::increaseBlockSize(std::uint32_t rva, st
 		{
 			base->SizeOfBlock += (num_entries * sizeof(uint16_t));
 			base->SizeOfBlock = (base->SizeOfBlock + 0x3) & ~0x3;
+			_invalidateIndex();
 			break;
 		}
 
@@ -273,4 +254,57 @@ void pepp::RelocationDirectory<bitsize>::adjustBlockToFit(uint32_t delta)
 	}
 
 	base->SizeOfBlock += delta;
+	_invalidateIndex();
+}
+
+template<unsigned int bitsize>
+void pepp::RelocationDirectory<bitsize>::_buildIndex() const
+{
+	if (m_indexBuilt.load(std::memory_order_acquire))
+		return;
+
+	std::lock_guard<std::mutex> lock(m_indexLock);
+
+	if (m_indexBuilt.load(std::memory_order_relaxed))
+		return;
+
+	m_index.clear();
+
+	// Blocks up to the first one that doesn't fit the image, a truncated table keeps what is readable.
+	forEachBlock([this](const detail::Image_t<>::RelocationBase_t& reloc, const std::uint16_t* entries, std::uint32_t count)
+		{
+			for (std::uint32_t i = 0; i < count; i++)
+			{
+				BlockEntry block(reloc.VirtualAddress, entries[i]);
+				if (block.getType() == REL_BASED_ABSOLUTE)
+					continue;
+
+				m_index.push_back({ block.getRva(), static_cast<std::uint32_t>((const char*)&entries[i] - (const char*)m_base) });
+			}
+
+			return true;
+		});
+
+	// Stable, a duplicate rva resolves to its first entry like the block walk did.
+	std::stable_sort(m_index.begin(), m_index.end(),
+		[](const IndexEntry_t& lhs, const IndexEntry_t& rhs) { return lhs.rva < rhs.rva; });
+
+	m_indexBuilt.store(true, std::memory_order_release);
+}
+
+template<unsigned int bitsize>
+std::uint16_t* pepp::RelocationDirectory<bitsize>::_findEntry(std::uint32_t rva) const
+{
+	if (!isPresent())
+		return nullptr;
+
+	_buildIndex();
+
+	auto it = std::lower_bound(m_index.begin(), m_index.end(), rva,
+		[](const IndexEntry_t& entry, std::uint32_t rva) { return entry.rva < rva; });
+
+	if (it == m_index.end() || it->rva != rva)
+		return nullptr;
+
+	return (std::uint16_t*)((char*)m_base + it->entry_offset);
 }
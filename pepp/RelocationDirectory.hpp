@@ -1,5 +1,8 @@
 #pragma once
 
+#include <mutex>
+#include <atomic>
+
 namespace pepp
 {
 	/*
@@ -67,18 +70,22 @@ namespace pepp
 		std::uint16_t*						 m_base;
 		std::uint32_t					     m_idx;
 		detail::Image_t<>::RelocationBase_t* m_reloc;
+		//! Relocation index of the directory the block belongs to, invalidated on append
+		std::atomic<bool>*					 m_indexBuilt;
 	public:
 		BlockStream()
 			: m_base(nullptr)
 			, m_idx(0)
 			, m_reloc(nullptr)
+			, m_indexBuilt(nullptr)
 		{
 		}
 
-		BlockStream(detail::Image_t<>::RelocationBase_t* reloc)
+		BlockStream(detail::Image_t<>::RelocationBase_t* reloc, std::atomic<bool>* index_built = nullptr)
 			: m_base((std::uint16_t*)(reloc + 1))
 			, m_idx(0)
 			, m_reloc(reloc)
+			, m_indexBuilt(index_built)
 		{
 			while (m_base[m_idx])
 			{
@@ -86,17 +93,21 @@ namespace pepp
 			}
 		}
 
-		void append(RelocationType type, std::uint16_t offset)
+		//! False if the stream is invalid or the block is full (use RelocationBuilder to grow the table)
+		bool append(RelocationType type, std::uint16_t offset)
 		{
 			if (m_base == nullptr)
-				return;
+				return false;
 
 			if (m_idx * sizeof(uint16_t) >= (m_reloc->SizeOfBlock - sizeof(*m_reloc)))
-			{
-				__debugbreak();
-			}
+				return false;
 
 			m_base[m_idx++] = craftRelocationBlockEntry(type, offset);
+
+			if (m_indexBuilt != nullptr)
+				m_indexBuilt->store(false, std::memory_order_release);
+
+			return true;
 		}
 
 		std::uint32_t index() const
@@ -110,40 +121,101 @@ namespace pepp
 		}
 	};
 
+	template<unsigned int bitsize>
+	class RelocationBuilder;
+
 	template<unsigned int bitsize>
 	class RelocationDirectory : pepp::msc::NonCopyable
 	{
 		friend class Image<32>;
 		friend class Image<64>;
+		friend class RelocationBuilder<bitsize>;
 
 		using PatchType_t = typename detail::Image_t<bitsize>::Address_t;
 
+		//! One relocation of the index: its rva and where its entry is, in bytes from m_base
+		struct IndexEntry_t
+		{
+			std::uint32_t	rva;
+			std::uint32_t	entry_offset;
+		};
+
 		Image<bitsize>*							m_image;
 		detail::Image_t<>::RelocationBase_t*	m_base;
 		SectionHeader*							m_section;
+		//! Every relocation sorted by rva, built on the first lookup and rebuilt after the blocks change
+		mutable std::vector<IndexEntry_t>		m_index;
+		mutable std::atomic<bool>				m_indexBuilt{ false };
+		mutable std::mutex						m_indexLock;
 	public:
 
 		int			getNumBlocks() const;
 		int			getNumEntries(detail::Image_t<>::RelocationBase_t* reloc) const;
 		std::uint32_t	getRemainingFreeBytes() const;
 		bool			changeRelocationType(std::uint32_t rva, RelocationType type);
-		std::vector<BlockEntry> getBlockEntries(int blockIdx);
+		std::vector<BlockEntry> getBlockEntries(int blockIdx) const;
 		BlockStream createBlock(std::uint32_t rva, std::uint32_t num_entries);
 		BlockStream getBlockStream(std::uint32_t rva);
 		void extend(std::uint32_t num_entries);
-		void forEachEntry(std::function<void(BlockEntry&)> Callback);
+		void forEachEntry(std::function<void(BlockEntry&)> Callback) const;
+		//! Is there a relocation at `rva`? Binary search in the relocation index (padding entries aren't relocations).
 		bool isRelocationPresent(std::uint32_t rva) const;
+		//! Type of the relocation at `rva`, false if there is none
+		bool getRelocationType(std::uint32_t rva, RelocationType& type) const;
 		std::uint32_t getTotalBlockSize();
 		void increaseBlockSize(std::uint32_t rva, std::uint32_t num_entries);
 		void adjustBlockToFit(uint32_t delta);
 		detail::Image_t<>::RelocationBase_t* getBase() { return m_base; }
 
+		//! Call `visitor(block, entries, num_entries)` for every block, `entries` point into the image.
+		//! Like the loader, the walk ends after the directory's Size bytes (or at a zeroed block).
+		//! Stops and returns false once the visitor returns false, or at a block that runs past the directory or the image.
+		template<typename Visitor>
+		bool forEachBlock(Visitor&& visitor) const
+		{
+			if (!isPresent())
+				return true;
+
+			auto base = m_base;
+			const char* viewEnd = (const char*)m_image->view().data() + m_image->view().size();
+
+			if ((const char*)base > viewEnd)
+				return false;
+
+			const std::size_t dirSize = m_image->getPEHdr().getOptionalHdr().getDataDir(DIRECTORY_ENTRY_BASERELOC).Size;
+			const char* end = (const char*)base + (std::min)(dirSize, std::size_t(viewEnd - (const char*)base));
+
+			while ((const char*)(base + 1) <= end && base->VirtualAddress)
+			{
+				if (base->SizeOfBlock < sizeof(*base) || base->SizeOfBlock > std::size_t(end - (const char*)base))
+					return false;
+
+				if (!visitor(*base, (const std::uint16_t*)(base + 1), static_cast<std::uint32_t>(getNumEntries(base))))
+					return false;
+
+				base = decltype(base)((char*)base + base->SizeOfBlock);
+			}
+
+			return true;
+		}
+
 		bool isPresent() const {
 			return m_image->getPEHdr().getOptionalHdr().getDataDir(DIRECTORY_ENTRY_BASERELOC).Size > 0;
 		}
 	private:
+		//! Build m_index if it isn't already (or the blocks changed since), safe to call from several threads
+		void _buildIndex() const;
+
+		//! Entry of the relocation at `rva` in the index, nullptr if there is none
+		std::uint16_t* _findEntry(std::uint32_t rva) const;
+
+		void _invalidateIndex() const {
+			m_indexBuilt.store(false, std::memory_order_release);
+		}
+
 		//! Setup the directory
 		void _setup(Image<bitsize>* image) {
+			_invalidateIndex();
 			m_image = image;
 			m_base = reinterpret_cast<decltype(m_base)>(
 				&image->base()[image->getPEHdr().rvaToOffset(
@@ -0,0 +1,218 @@
+#include "PELibrary.hpp"
+#include "misc/Simd.hpp"
+#include <algorithm>
+#include <bit>
+
+using namespace pepp;
+
+SectionIndex::Table::Table()
+{
+	for (int i = 0; i < 4; i++)
+		m_columns[i] = m_inline[i];
+
+	_build(nullptr, nullptr, nullptr, 0);
+}
+
+void SectionIndex::Table::_build(const std::uint32_t* begins, const std::uint32_t* sizes, const std::uint32_t* targets, std::uint32_t count)
+{
+	std::uint32_t slots[INLINE_SECTIONS];
+	std::vector<std::uint32_t> spillSlots;
+	std::uint32_t* order = slots;
+
+	m_count = 0;
+	m_overlaps = false;
+	m_lastHit.store(0, std::memory_order_relaxed);
+
+	if (count > INLINE_SECTIONS)
+	{
+		spillSlots.resize(count);
+		order = spillSlots.data();
+		m_spill.resize(4 * count);
+		for (int i = 0; i < 4; i++)
+			m_columns[i] = &m_spill[i * count];
+	}
+	else
+	{
+		m_spill.clear();
+		for (int i = 0; i < 4; i++)
+			m_columns[i] = m_inline[i];
+	}
+
+	//
+	// Only non-empty intervals take part.
+	for (std::uint32_t n = 0; n < count; n++)
+	{
+		if (sizes[n] != 0)
+			order[m_count++] = n;
+	}
+
+	//
+	// Sort by start, keep header order on ties.
+	std::stable_sort(order, order + m_count,
+		[begins](std::uint32_t lhs, std::uint32_t rhs) { return begins[lhs] < begins[rhs]; });
+
+	for (std::uint32_t slot = 0; slot < m_count; slot++)
+	{
+		std::uint32_t n = order[slot];
+
+		m_columns[0][slot] = begins[n];
+		m_columns[1][slot] = begins[n] + sizes[n];
+		m_columns[2][slot] = targets[n];
+		m_columns[3][slot] = n;
+
+		if (slot > 0 && m_columns[0][slot] < m_columns[1][slot - 1])
+			m_overlaps = true;
+	}
+
+	//
+	// Pad the inline table with empty intervals, these never match.
+	if (m_columns[0] == m_inline[0])
+	{
+		for (std::uint32_t slot = m_count; slot < INLINE_SECTIONS; slot++)
+		{
+			m_inline[0][slot] = 0;
+			m_inline[1][slot] = 0;
+			m_inline[2][slot] = 0;
+			m_inline[3][slot] = SECTION_NOT_FOUND;
+		}
+	}
+}
+
+std::uint32_t SectionIndex::Table::find(std::uint32_t value) const noexcept
+{
+	const std::uint32_t* b = begin();
+	const std::uint32_t* e = end();
+	std::uint32_t slot;
+
+	if (m_count == 0)
+		return SECTION_NOT_FOUND;
+
+	if (m_overlaps)
+	{
+		//
+		// Malformed image with overlapping sections, return the first match in header order
+		// just like a linear scan over the headers would.
+		slot = SECTION_NOT_FOUND;
+
+		for (std::uint32_t i = 0; i < m_count; i++)
+		{
+			if (value - b[i] < e[i] - b[i] && (slot == SECTION_NOT_FOUND || section()[i] < section()[slot]))
+				slot = i;
+		}
+
+		return slot;
+	}
+
+	//
+	// Consecutive lookups (directory walks, relocations..) mostly stay within one section.
+	slot = m_lastHit.load(std::memory_order_relaxed);
+	if (slot < m_count && value - b[slot] < e[slot] - b[slot])
+		return slot;
+
+	//
+	// Find the last interval starting at or below `value`, the loop body compiles to a cmov.
+	std::uint32_t lo = 0;
+	std::uint32_t n = m_count;
+
+	while (n > 1)
+	{
+		std::uint32_t half = n / 2;
+		lo = (b[lo + half] <= value) ? lo + half : lo;
+		n -= half;
+	}
+
+	// Unsigned compare also rejects value < begin.
+	if (value - b[lo] >= e[lo] - b[lo])
+		return SECTION_NOT_FOUND;
+
+	m_lastHit.store(lo, std::memory_order_relaxed);
+	return lo;
+}
+
+void SectionIndex::Table::translateMany(const std::uint32_t* in, std::uint32_t* out, std::size_t count, std::uint32_t miss) const noexcept
+{
+#if PEPP_HAS_SSE2
+	if (!m_overlaps && m_columns[0] == m_inline[0] && m_count != 0)
+	{
+		//
+		// value is inside slot i when (value - begin[i]) < (end[i] - begin[i]) (unsigned).
+		// SSE2 only has signed compares, so both sides are biased by 0x80000000.
+		const __m128i bias = _mm_set1_epi32((int)0x80000000);
+		const std::uint32_t groups = (m_count + 3) / 4;
+		__m128i begins[INLINE_SECTIONS / 4];
+		__m128i sizes[INLINE_SECTIONS / 4];
+
+		for (std::uint32_t g = 0; g < groups; g++)
+		{
+			begins[g] = _mm_loadu_si128((const __m128i*)&m_inline[0][g * 4]);
+			sizes[g] = _mm_xor_si128(_mm_sub_epi32(_mm_loadu_si128((const __m128i*)&m_inline[1][g * 4]), begins[g]), bias);
+		}
+
+		for (std::size_t i = 0; i < count; i++)
+		{
+			const std::uint32_t value = in[i];
+			const __m128i v = _mm_set1_epi32((int)value);
+			std::uint32_t mask = 0;
+
+			for (std::uint32_t g = 0; g < groups; g++)
+			{
+				__m128i delta = _mm_xor_si128(_mm_sub_epi32(v, begins[g]), bias);
+				__m128i inside = _mm_cmpgt_epi32(sizes[g], delta);
+				mask |= (std::uint32_t)_mm_movemask_ps(_mm_castsi128_ps(inside)) << (g * 4);
+			}
+
+			// Intervals don't overlap, so at most one bit is set.
+			std::uint32_t slot = std::countr_zero(mask);
+			out[i] = mask ? m_inline[2][slot] + (value - m_inline[0][slot]) : miss;
+		}
+
+		return;
+	}
+#endif
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		std::uint32_t result = translate(in[i]);
+		out[i] = result != SECTION_NOT_FOUND ? result : miss;
+	}
+}
+
+void SectionIndex::build(const SectionHeader* sections, std::uint16_t count)
+{
+	std::uint32_t inlineColumns[3][INLINE_SECTIONS];
+	std::vector<std::uint32_t> spill;
+	std::uint32_t* va = inlineColumns[0];
+	std::uint32_t* vsize = inlineColumns[1];
+	std::uint32_t* ptr = inlineColumns[2];
+
+	if (count > INLINE_SECTIONS)
+	{
+		spill.resize(4 * count);
+		va = &spill[0];
+		vsize = &spill[count];
+		ptr = &spill[2 * count];
+	}
+
+	for (std::uint16_t n = 0; n < count; n++)
+	{
+		va[n] = sections[n].getVirtualAddress();
+		vsize[n] = sections[n].getVirtualSize();
+		ptr[n] = sections[n].getPtrToRawData();
+	}
+
+	// RVA -> offset, covering [VirtualAddress, VirtualAddress + VirtualSize)
+	m_byRva._build(va, vsize, ptr, count);
+
+	// Offset -> RVA, covering [PointerToRawData, PointerToRawData + SizeOfRawData)
+	std::uint32_t* rawsize = count > INLINE_SECTIONS ? &spill[3 * count] : vsize;
+	for (std::uint16_t n = 0; n < count; n++)
+		rawsize[n] = sections[n].getSizeOfRawData();
+
+	m_byOffset._build(ptr, rawsize, va, count);
+}
+
+void SectionIndex::clear()
+{
+	m_byRva._build(nullptr, nullptr, nullptr, 0);
+	m_byOffset._build(nullptr, nullptr, nullptr, 0);
+}
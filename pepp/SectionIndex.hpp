@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+
+namespace pepp
+{
+	//! Returned by SectionIndex lookups that don't land in any section
+	static constexpr std::uint32_t SECTION_NOT_FOUND = 0xffffffff;
+
+	class SectionHeader;
+
+	///
+	// - class SectionIndex
+	// - Sorted interval table over the section headers, used for RVA <-> file offset translation
+	// - with a binary search instead of a linear scan (and no section name compares).
+	// - Built by `class Image` every time the image is (re)validated.
+	///
+	class SectionIndex : pepp::msc::NonCopyable
+	{
+	public:
+		//! Most images have less sections than this, so the tables don't need the heap
+		static constexpr std::uint32_t INLINE_SECTIONS = 16;
+
+		//! One interval table, struct-of-arrays sorted by `begin`
+		class Table
+		{
+			friend class SectionIndex;
+
+			std::uint32_t				m_inline[4][INLINE_SECTIONS];
+			std::vector<std::uint32_t>	m_spill;
+			std::uint32_t*				m_columns[4];
+			std::uint32_t				m_count = 0;
+			bool						m_overlaps = false;
+			mutable std::atomic<std::uint32_t> m_lastHit{ 0 };
+		public:
+			Table();
+
+			//! First value covered by each interval
+			const std::uint32_t* begin() const { return m_columns[0]; }
+			//! One past the last value covered by each interval
+			const std::uint32_t* end() const { return m_columns[1]; }
+			//! What `begin` translates to
+			const std::uint32_t* target() const { return m_columns[2]; }
+			//! Index of the section in the raw section headers
+			const std::uint32_t* section() const { return m_columns[3]; }
+
+			std::uint32_t count() const { return m_count; }
+
+			//! Do any intervals overlap (malformed section table)?
+			bool overlaps() const { return m_overlaps; }
+
+			//! Find the table slot containing `value`, or SECTION_NOT_FOUND
+			std::uint32_t find(std::uint32_t value) const noexcept;
+
+			//! Translate `value` through the table, returns SECTION_NOT_FOUND on a miss
+			std::uint32_t translate(std::uint32_t value) const noexcept {
+				std::uint32_t slot = find(value);
+				if (slot == SECTION_NOT_FOUND)
+					return SECTION_NOT_FOUND;
+				return target()[slot] + (value - begin()[slot]);
+			}
+
+			//! Translate `count` values at once, misses are written as `miss`.
+			//! Small tables are matched with SIMD compares against every interval at once.
+			void translateMany(const std::uint32_t* in, std::uint32_t* out, std::size_t count, std::uint32_t miss) const noexcept;
+
+		private:
+			void _build(const std::uint32_t* begins, const std::uint32_t* sizes, const std::uint32_t* targets, std::uint32_t count);
+		};
+
+		///
+		// - Remembers the last interval it hit, for walks that mostly stay inside one section.
+		// - Unlike the table's own last-hit cache it isn't shared, so every walker keeps its own.
+		///
+		class Cursor
+		{
+			const Table*	m_table = nullptr;
+			std::uint32_t	m_begin = 0;
+			std::uint32_t	m_end = 0;
+			std::uint32_t	m_target = 0;
+		public:
+			Cursor() = default;
+			explicit Cursor(const Table& table) : m_table(&table) {}
+
+			//! Translate `value` through the table, returns SECTION_NOT_FOUND on a miss
+			std::uint32_t translate(std::uint32_t value) noexcept {
+				if (value - m_begin < m_end - m_begin)
+					return m_target + (value - m_begin);
+
+				std::uint32_t slot = m_table->find(value);
+				if (slot == SECTION_NOT_FOUND)
+					return SECTION_NOT_FOUND;
+
+				// Overlapping intervals need the full lookup every time.
+				if (!m_table->overlaps())
+				{
+					m_begin = m_table->begin()[slot];
+					m_end = m_table->end()[slot];
+					m_target = m_table->target()[slot];
+				}
+
+				return m_table->target()[slot] + (value - m_table->begin()[slot]);
+			}
+		};
+
+		SectionIndex() = default;
+
+		//! (Re)build the tables from the raw section headers
+		void build(const SectionHeader* sections, std::uint16_t count);
+
+		//! Forget all sections
+		void clear();
+
+		//! Index of the section containing the RVA, or SECTION_NOT_FOUND
+		std::uint32_t findByRva(std::uint32_t rva) const noexcept {
+			std::uint32_t slot = m_byRva.find(rva);
+			return slot == SECTION_NOT_FOUND ? slot : m_byRva.section()[slot];
+		}
+
+		//! Index of the section containing the file offset, or SECTION_NOT_FOUND
+		std::uint32_t findByOffset(std::uint32_t offset) const noexcept {
+			std::uint32_t slot = m_byOffset.find(offset);
+			return slot == SECTION_NOT_FOUND ? slot : m_byOffset.section()[slot];
+		}
+
+		//! RVA -> file offset, SECTION_NOT_FOUND if no section holds the RVA
+		std::uint32_t rvaToOffset(std::uint32_t rva) const noexcept {
+			return m_byRva.translate(rva);
+		}
+
+		//! File offset -> RVA, SECTION_NOT_FOUND if no section holds the offset
+		std::uint32_t offsetToRva(std::uint32_t offset) const noexcept {
+			return m_byOffset.translate(offset);
+		}
+
+		const Table& rvaTable() const { return m_byRva; }
+		const Table& offsetTable() const { return m_byOffset; }
+
+	private:
+		Table	m_byRva;
+		Table	m_byOffset;
+	};
+}
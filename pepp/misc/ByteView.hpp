@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include "ByteVector.hpp"
+
+namespace pepp::mem {
+	//
+	//! Non-owning window over a block of bytes (a ByteVector, a file mapping or caller memory).
+	//! Offers the same as/deref accessors as ByteVector, so parsing code works on either.
+	//
+	class ByteView
+	{
+		std::uint8_t*	m_data = nullptr;
+		std::size_t		m_size = 0;
+	public:
+		constexpr ByteView() = default;
+
+		constexpr ByteView(std::uint8_t* data, std::size_t size)
+			: m_data(data)
+			, m_size(size)
+		{
+		}
+
+		ByteView(ByteVector& vec)
+			: m_data(vec.data())
+			, m_size(vec.size())
+		{
+		}
+
+		constexpr std::uint8_t* data() const {
+			return m_data;
+		}
+
+		constexpr std::size_t size() const {
+			return m_size;
+		}
+
+		constexpr bool empty() const {
+			return m_size == 0;
+		}
+
+		constexpr std::uint8_t* begin() const {
+			return m_data;
+		}
+
+		constexpr std::uint8_t* end() const {
+			return m_data + m_size;
+		}
+
+		std::uint8_t& operator[](std::size_t idx) {
+			return m_data[idx];
+		}
+
+		const std::uint8_t& operator[](std::size_t idx) const {
+			return m_data[idx];
+		}
+
+		//
+		//! Bounds checked access, throws std::out_of_range like std::vector::at
+		//
+		std::uint8_t& at(std::size_t idx) {
+			if (idx >= m_size)
+				throw std::out_of_range("ByteView::at");
+			return m_data[idx];
+		}
+
+		const std::uint8_t& at(std::size_t idx) const {
+			if (idx >= m_size)
+				throw std::out_of_range("ByteView::at");
+			return m_data[idx];
+		}
+
+		//
+		//! Interpret data as T
+		//! Example: as<char*>(0x0/)
+		//
+		template<typename T>
+		T as(std::size_t idx = 0x0) const {
+			return (T)(&at(idx));
+		}
+		template<typename T>
+		T as(std::size_t idx = 0x0) {
+			return (T)(&at(idx));
+		}
+
+		//
+		//! Dereference bytes as T
+		//! Example: deref<char*>(0x0/)
+		//
+		template<typename T>
+		T deref(std::size_t idx = 0x0) const {
+			return *(T*)(&at(idx));
+		}
+		template<typename T>
+		T& deref(std::size_t idx = 0x0) {
+			return *(T*)(&at(idx));
+		}
+	};
+}
@@ -59,13 +59,29 @@ namespace pepp::io {
 		m_in_file.open(m_filename, m_flags & ~kFileOutput);
 
 		if (m_in_file.is_open()) {
-			file_buffer = std::vector<std::uint8_t>(std::istreambuf_iterator<char>(m_in_file), {});
+			file_buffer.resize(GetSize());
+			m_in_file.read((char*)file_buffer.data(), file_buffer.size());
+			file_buffer.resize(m_in_file.gcount());
 			m_in_file.close();
 		}
 
 		return file_buffer;
 	}
 
+	bool File::Read(void* data, size_t size)
+	{
+		m_in_file.open(m_filename, m_flags & ~kFileOutput);
+
+		if (!m_in_file.is_open())
+			return false;
+
+		m_in_file.read((char*)data, size);
+		bool result = m_in_file.gcount() == (std::streamsize)size;
+		m_in_file.close();
+
+		return result;
+	}
+
 	std::uintmax_t File::GetSize()
 	{
 		return std::filesystem::file_size(m_filename);
@@ -25,6 +25,7 @@ namespace pepp::io
         void Write(void* data, size_t size);
         bool Exists();
         std::vector<std::uint8_t> Read();
+        bool Read(void* data, size_t size);
         std::uintmax_t GetSize();
 
         File& operator=(File&& rhs);
@@ -0,0 +1,139 @@
+#include <utility>
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace pepp::io {
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(std::string_view filename, bool copy_on_write)
+	{
+		Close();
+
+		std::string path(filename);
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size{};
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		void* view = MapViewOfFile(mapping, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+		if (view == nullptr)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+
+		m_file = file;
+		m_mapping = mapping;
+		m_data = static_cast<std::uint8_t*>(view);
+		m_size = static_cast<std::size_t>(size.QuadPart);
+#else
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat st{};
+		if (fstat(fd, &st) != 0 || st.st_size == 0)
+		{
+			close(fd);
+			return false;
+		}
+
+		void* view = mmap(nullptr, st.st_size, copy_on_write ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_PRIVATE, fd, 0);
+
+		// The mapping holds its own reference to the file.
+		close(fd);
+
+		if (view == MAP_FAILED)
+			return false;
+
+		m_data = static_cast<std::uint8_t*>(view);
+		m_size = static_cast<std::size_t>(st.st_size);
+#endif
+
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_data == nullptr)
+			return;
+
+#ifdef _WIN32
+		UnmapViewOfFile(m_data);
+		CloseHandle(m_mapping);
+		CloseHandle(m_file);
+		m_mapping = nullptr;
+		m_file = nullptr;
+#else
+		munmap(m_data, m_size);
+#endif
+
+		m_data = nullptr;
+		m_size = 0;
+	}
+
+	bool MappedFile::IsOpen() const
+	{
+		return m_data != nullptr;
+	}
+
+	std::uint8_t* MappedFile::Data() const
+	{
+		return m_data;
+	}
+
+	std::size_t MappedFile::Size() const
+	{
+		return m_size;
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& rhs) noexcept
+	{
+		if (this == &rhs)
+			return *this;
+
+		Close();
+
+		std::swap(m_data, rhs.m_data);
+		std::swap(m_size, rhs.m_size);
+#ifdef _WIN32
+		std::swap(m_file, rhs.m_file);
+		std::swap(m_mapping, rhs.m_mapping);
+#endif
+		return *this;
+	}
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace pepp::io
+{
+    //
+    //! A file mapped into memory. Pages are only faulted in when touched, so
+    //! nothing is read up front and the file contents are never copied.
+    //! Copy-on-write mappings may be written to, but changes never reach the disk.
+    //
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        MappedFile(const MappedFile& other) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        ~MappedFile();
+
+        bool Open(std::string_view filename, bool copy_on_write = true);
+        void Close();
+        bool IsOpen() const;
+        std::uint8_t* Data() const;
+        std::size_t Size() const;
+
+        MappedFile& operator=(const MappedFile& rhs) = delete;
+        MappedFile& operator=(MappedFile&& rhs) noexcept;
+
+    private:
+        std::uint8_t* m_data = nullptr;
+        std::size_t   m_size = 0;
+#ifdef _WIN32
+        void*         m_file = nullptr;
+        void*         m_mapping = nullptr;
+#endif
+    };
+}
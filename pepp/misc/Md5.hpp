@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace pepp::msc
+{
+    //
+    //! Incremental MD5 (RFC 1321). Only used for fingerprints like the imphash, not for anything security related.
+    //
+    class Md5 {
+    public:
+        using Digest_t = std::array<std::uint8_t, 16>;
+
+        Md5();
+
+        void Update(const void* data, std::size_t size);
+
+        //! Pads and returns the digest, the object has to be Reset() before it is used again
+        Digest_t Final();
+
+        void Reset();
+
+        //! Lowercase hex form of a digest
+        static std::string ToHex(const Digest_t& digest);
+
+    private:
+        void Transform(const std::uint8_t* block);
+
+        std::uint32_t               m_state[4];
+        std::uint64_t               m_length;
+        std::uint8_t                m_buffer[64];
+    };
+}
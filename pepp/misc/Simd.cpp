@@ -0,0 +1,64 @@
+#include "Simd.hpp"
+
+#if PEPP_ARCH_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace pepp::simd {
+
+#if PEPP_ARCH_X86
+	static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+	{
+#ifdef _MSC_VER
+		__cpuidex((int*)regs, (int)leaf, (int)subleaf);
+#else
+		__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	}
+
+	static std::uint64_t xgetbv0()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		std::uint32_t lo, hi;
+		__asm__ volatile ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+		return ((std::uint64_t)hi << 32) | lo;
+#endif
+	}
+#endif
+
+	const CpuFeatures_t& cpuFeatures() noexcept
+	{
+		static const CpuFeatures_t features = [] {
+			CpuFeatures_t result{};
+#if PEPP_ARCH_X86
+			unsigned int regs[4]{};
+
+			cpuid(0, 0, regs);
+			unsigned int maxLeaf = regs[0];
+
+			cpuid(1, 0, regs);
+			result.sse42 = (regs[2] & (1u << 20)) != 0;
+
+			//
+			// AVX state must be enabled by the OS (OSXSAVE + XCR0 bits 1 and 2).
+			bool osAvx = (regs[2] & (1u << 27)) && (regs[2] & (1u << 28)) && (xgetbv0() & 0x6) == 0x6;
+
+			if (osAvx && maxLeaf >= 7)
+			{
+				cpuid(7, 0, regs);
+				result.avx2 = (regs[1] & (1u << 5)) != 0;
+			}
+#endif
+			return result;
+		}();
+
+		return features;
+	}
+
+}
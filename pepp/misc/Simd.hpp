@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PEPP_ARCH_X86 1
+#include <immintrin.h>
+#else
+#define PEPP_ARCH_X86 0
+#endif
+
+//
+//! SSE2 is part of the x64 baseline (and of /arch:SSE2 on x86), so it needs no runtime check.
+//
+#if PEPP_ARCH_X86 && (defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__))
+#define PEPP_HAS_SSE2 1
+#else
+#define PEPP_HAS_SSE2 0
+#endif
+
+//
+//! Lets a single function use an instruction set the rest of the build doesn't enable.
+//! MSVC always allows intrinsics, so there it expands to nothing.
+//
+#if defined(__GNUC__) || defined(__clang__)
+#define PEPP_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PEPP_TARGET(isa)
+#endif
+
+namespace pepp::simd
+{
+	struct CpuFeatures_t
+	{
+		bool sse42 = false;
+		bool avx2 = false;
+	};
+
+	//! Instruction sets usable on this machine (CPU and OS support), detected once
+	const CpuFeatures_t& cpuFeatures() noexcept;
+}
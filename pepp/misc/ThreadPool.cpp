@@ -0,0 +1,177 @@
+#include "ThreadPool.hpp"
+
+using namespace pepp::msc;
+
+namespace
+{
+    //
+    // Pools whose jobs the current thread is inside of, innermost first.
+    struct RunningJob_t
+    {
+        const ThreadPool*   pool;
+        const RunningJob_t* outer;
+    };
+
+    thread_local const RunningJob_t* t_runningJob = nullptr;
+}
+
+ThreadPool::ThreadPool(std::size_t threads)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+
+    // The thread calling ParallelFor() does its share of the work.
+    for (std::size_t i = 1; i < threads; i++)
+        m_threads.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+std::size_t ThreadPool::Size() const
+{
+    return m_threads.size() + 1;
+}
+
+ThreadPool& ThreadPool::Shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::ParallelFor(std::size_t count, const std::function<void(std::size_t)>& fn)
+{
+    if (count == 0)
+        return;
+
+    if (m_threads.empty() || count == 1)
+    {
+        for (std::size_t i = 0; i < count; i++)
+            fn(i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit(m_submit);
+    std::exception_ptr error;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &fn;
+        m_count = count;
+        m_next.store(0, std::memory_order_relaxed);
+        m_finished = 0;
+        m_error = nullptr;
+        m_generation++;
+    }
+
+    m_wake.notify_all();
+
+    RunJob(&fn, count);
+
+    {
+        //
+        // Workers that picked up the job must be out of it before `fn` goes away
+        // (or the next job resets the counters under them).
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this, count] { return m_finished == count && m_active == 0; });
+
+        m_job = nullptr;
+        error = m_error;
+        m_error = nullptr;
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void ThreadPool::WorkerLoop()
+{
+    std::uint64_t seen = 0;
+
+    for (;;)
+    {
+        const std::function<void(std::size_t)>* job;
+        std::size_t count;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this, seen] { return m_stop || (m_job != nullptr && m_generation != seen); });
+
+            if (m_stop)
+                return;
+
+            seen = m_generation;
+            job = m_job;
+            count = m_count;
+            m_active++;
+        }
+
+        RunJob(job, count);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_active--;
+        }
+
+        m_done.notify_all();
+    }
+}
+
+bool ThreadPool::InJob() const
+{
+    for (const RunningJob_t* running = t_runningJob; running != nullptr; running = running->outer)
+    {
+        if (running->pool == this)
+            return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::RunJob(const std::function<void(std::size_t)>* job, std::size_t count)
+{
+    std::size_t done = 0;
+
+    const RunningJob_t running{ this, t_runningJob };
+    t_runningJob = &running;
+
+    for (std::size_t i = m_next.fetch_add(1, std::memory_order_relaxed); i < count; i = m_next.fetch_add(1, std::memory_order_relaxed))
+    {
+        try
+        {
+            (*job)(i);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_error)
+                m_error = std::current_exception();
+        }
+
+        done++;
+    }
+
+    t_runningJob = running.outer;
+
+    if (done != 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_finished += done;
+        }
+
+        m_done.notify_all();
+    }
+}
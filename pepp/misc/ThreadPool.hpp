@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "NonCopyable.hpp"
+
+namespace pepp::msc
+{
+    //
+    //! Fixed set of worker threads running index-parallel jobs.
+    //! One job runs at a time: ParallelFor() calls from different threads are serialized,
+    //! and a job must not call ParallelFor() on the pool it is running on.
+    //
+    class ThreadPool : NonCopyable {
+    public:
+        //! `threads` == 0 uses one thread per hardware thread (the caller counts as one)
+        explicit ThreadPool(std::size_t threads = 0);
+        ~ThreadPool();
+
+        //! Threads taking part in a job, including the calling thread
+        std::size_t Size() const;
+
+        //! Run fn(0) .. fn(count - 1) across the pool and the calling thread, returns once all are done.
+        //! The first exception thrown by `fn` is rethrown here.
+        void ParallelFor(std::size_t count, const std::function<void(std::size_t)>& fn);
+
+        //! Is the calling thread running a job of this pool (directly or further down)?
+        //! ParallelFor() must not be called on the pool then, code that can be either way checks this first.
+        bool InJob() const;
+
+        //! Process wide pool, created on first use
+        static ThreadPool& Shared();
+
+    private:
+        void WorkerLoop();
+        void RunJob(const std::function<void(std::size_t)>* job, std::size_t count);
+
+        std::vector<std::thread>                    m_threads;
+        std::mutex                                  m_submit;
+        std::mutex                                  m_mutex;
+        std::condition_variable                     m_wake;
+        std::condition_variable                     m_done;
+        const std::function<void(std::size_t)>*     m_job = nullptr;
+        std::size_t                                 m_count = 0;
+        std::atomic<std::size_t>                    m_next{ 0 };
+        std::size_t                                 m_finished = 0;
+        std::size_t                                 m_active = 0;
+        std::uint64_t                               m_generation = 0;
+        std::exception_ptr                          m_error;
+        bool                                        m_stop = false;
+    };
+}
@@ -0,0 +1,118 @@
+//
+// Regression: relocateImage on a page that spans two sections (SectionAlignment under 4kb), whose second
+// section isn't placed right after the first in the file, and a relocation table followed by bytes that
+// look like another block but lie past the directory's Size.
+//
+// Build (from this directory):
+//   cl /std:c++20 /EHsc /I..\pepp RelocateSpanTest.cpp ..\pepp\*.cpp ..\pepp\misc\*.cpp
+//
+// Exits with 0 when every check passes.
+//
+#include "PELibrary.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+using namespace pepp;
+
+namespace
+{
+	constexpr std::uint64_t image_base = 0x140000000ull;
+	constexpr std::uint64_t new_base = 0x150000000ull;
+
+	int failures = 0;
+
+	void check(bool ok, const char* what)
+	{
+		std::printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+		if (!ok)
+			failures++;
+	}
+
+	//
+	// .text at rva 0x1000 (raw 0x400) and .data at rva 0x1800 (raw 0x1000), both 0x800 bytes: page 0x1000 covers both.
+	std::vector<std::uint8_t> makeImage()
+	{
+		std::vector<std::uint8_t> image(0x1800);
+
+		auto* dos = reinterpret_cast<IMAGE_DOS_HEADER*>(image.data());
+		dos->e_magic = IMAGE_DOS_SIGNATURE;
+		dos->e_lfanew = 0x40;
+
+		auto* nt = reinterpret_cast<IMAGE_NT_HEADERS64*>(image.data() + 0x40);
+		nt->Signature = IMAGE_NT_SIGNATURE;
+		nt->FileHeader.Machine = IMAGE_FILE_MACHINE_AMD64;
+		nt->FileHeader.NumberOfSections = 2;
+		nt->FileHeader.SizeOfOptionalHeader = sizeof(IMAGE_OPTIONAL_HEADER64);
+		nt->OptionalHeader.Magic = IMAGE_NT_OPTIONAL_HDR64_MAGIC;
+		nt->OptionalHeader.ImageBase = image_base;
+		nt->OptionalHeader.FileAlignment = 0x200;
+		nt->OptionalHeader.SectionAlignment = 0x200;
+		nt->OptionalHeader.SizeOfHeaders = 0x400;
+		nt->OptionalHeader.SizeOfImage = 0x2000;
+		nt->OptionalHeader.NumberOfRvaAndSizes = IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+
+		auto* sections = IMAGE_FIRST_SECTION(nt);
+		std::memcpy(sections[0].Name, ".text", 5);
+		sections[0].VirtualAddress = 0x1000;
+		sections[0].Misc.VirtualSize = 0x800;
+		sections[0].PointerToRawData = 0x400;
+		sections[0].SizeOfRawData = 0x800;
+		sections[0].Characteristics = IMAGE_SCN_CNT_CODE | IMAGE_SCN_MEM_EXECUTE | IMAGE_SCN_MEM_READ;
+
+		std::memcpy(sections[1].Name, ".data", 5);
+		sections[1].VirtualAddress = 0x1800;
+		sections[1].Misc.VirtualSize = 0x800;
+		sections[1].PointerToRawData = 0x1000;
+		sections[1].SizeOfRawData = 0x800;
+		sections[1].Characteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ | IMAGE_SCN_MEM_WRITE;
+
+		auto pointer = [&](std::uint32_t offset, std::uint64_t value) { std::memcpy(image.data() + offset, &value, sizeof(value)); };
+		pointer(0x410, image_base + 0x1000);		// rva 0x1010, .text
+		pointer(0x1010, image_base + 0x1800);		// rva 0x1810, .data
+		pointer(0x420, image_base + 0x1020);		// rva 0x1020, .text
+
+		//
+		// The table at rva 0x1900 (raw 0x1100), one block for page 0x1000. A block for rva 0x1030 follows it,
+		// outside the directory.
+		auto* block = reinterpret_cast<IMAGE_BASE_RELOCATION*>(image.data() + 0x1100);
+		auto* entries = reinterpret_cast<std::uint16_t*>(block + 1);
+		block->VirtualAddress = 0x1000;
+		block->SizeOfBlock = sizeof(IMAGE_BASE_RELOCATION) + 4 * sizeof(std::uint16_t);
+		entries[0] = craftRelocationBlockEntry(REL_BASED_DIR64, 0x010);
+		entries[1] = craftRelocationBlockEntry(REL_BASED_DIR64, 0x810);
+		entries[2] = craftRelocationBlockEntry(REL_BASED_DIR64, 0x020);
+
+		auto* stray = reinterpret_cast<IMAGE_BASE_RELOCATION*>(image.data() + 0x1100 + block->SizeOfBlock);
+		stray->VirtualAddress = 0x1000;
+		stray->SizeOfBlock = sizeof(IMAGE_BASE_RELOCATION) + 2 * sizeof(std::uint16_t);
+		reinterpret_cast<std::uint16_t*>(stray + 1)[0] = craftRelocationBlockEntry(REL_BASED_DIR64, 0x030);
+
+		nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC] = { 0x1900, block->SizeOfBlock };
+		return image;
+	}
+
+	std::uint64_t at(Image64& image, std::uint32_t offset)
+	{
+		std::uint64_t value;
+		std::memcpy(&value, image.base() + offset, sizeof(value));
+		return value;
+	}
+}
+
+int main()
+{
+	std::vector<std::uint8_t> data = makeImage();
+
+	Image64 image;
+	image.setFromMemory(data.data(), data.size());
+
+	check(!image.getRelocDir().isRelocationPresent(0x1030), "the block past the directory's Size is not a relocation");
+	check(image.relocateImage(static_cast<uintptr_t>(new_base)), "relocateImage accepts a page spanning two sections");
+	check(at(image, 0x410) == new_base + 0x1000, "fixup in the page's own section");
+	check(at(image, 0x1010) == new_base + 0x1800, "fixup in the next section");
+	check(at(image, 0x420) == new_base + 0x1020, "fixup after the one in the next section");
+	check(at(image, 0x430) == 0, "the block past the directory's Size is not applied");
+
+	return failures != 0;
+}